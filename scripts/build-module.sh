@@ -81,6 +81,9 @@ cat src/module.json > dist/eucalypso/module.json
 if [ -f "src/help.json" ]; then
     cat src/help.json > dist/eucalypso/help.json
 fi
+if [ -f "src/presets.eupl" ]; then
+    cat src/presets.eupl > dist/eucalypso/presets.eupl
+fi
 cat build/dsp.so > dist/eucalypso/dsp.so
 chmod +x dist/eucalypso/dsp.so
 
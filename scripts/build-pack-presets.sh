@@ -0,0 +1,34 @@
+#!/usr/bin/env bash
+# Build the preset library packer (tools/eucalypso_pack_presets.c) for the local machine.
+#
+# Example:
+#   ./scripts/build-pack-presets.sh
+#   ./build/eucalypso_pack_presets -o src/presets.eupl presets/*.json
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+REPO_ROOT="$(dirname "$SCRIPT_DIR")"
+
+cd "$REPO_ROOT"
+
+MOVE_ANYTHING_SRC="${MOVE_ANYTHING_SRC:-$REPO_ROOT/../move-anything/src}"
+if [ ! -d "$MOVE_ANYTHING_SRC/host" ]; then
+    echo "Error: host headers not found at: $MOVE_ANYTHING_SRC/host"
+    echo "Set MOVE_ANYTHING_SRC to your move-anything src directory."
+    exit 1
+fi
+
+mkdir -p build
+
+echo "Building eucalypso_pack_presets..."
+${CC:-cc} -std=c11 -O2 -Wall -Wextra \
+    -DEUCALYPSO_DEBUG_LOG=0 \
+    -I src \
+    -I src/dsp \
+    -I "$MOVE_ANYTHING_SRC" \
+    tools/eucalypso_pack_presets.c \
+    src/dsp/eucalypso.c \
+    -o build/eucalypso_pack_presets \
+    -lm
+
+echo "Output: build/eucalypso_pack_presets"
@@ -12,25 +12,68 @@
  * compatible with the UI while the lane engine is built out.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdint.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <math.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "host/midi_fx_api_v1.h"
 #include "host/plugin_api_v1.h"
 
 #define MAX_LANES 4
+#define MAX_PARTS 4
 #define MAX_HELD_NOTES 16
 #define MAX_REGISTER_NOTES 24
 #define MAX_VOICES 64
+#define MAX_PENDING_NOTES 64
+#define MAX_EARLY_MS 200
+/* Legato gates span up to a full lane period at the 1600% gate limit; a
+ * 128-step pingpong lane repeats every 2 * 128 - 2 = 254 steps. */
+#define MAX_VOICE_GATE_PCT (1600 * 254)
+#define LEGATO_MASK_WORDS 4
+#define EVOLVE_PULSE_SPAN 3
+#define EVOLVE_DROP_SPAN 30
+#define EVOLVE_WINDOW_CYCLES 16
 #define DEFAULT_BPM 120
 #define DEFAULT_SAMPLE_RATE 44100
+#define FLICKS_PER_SECOND 705600000ull
 #define SCALE_BASE_NOTE 60
 #define DRUMPAD_BASE_NOTE 36
 #define DRUMPAD_COUNT 16
 #define CLOCK_START_GRACE_TICKS 2
+#define DEFAULT_CLOCK_LOSS_MULT 8
+#define DEFAULT_TRIG_NOTE 36
+#define DEFAULT_CATCHUP_MS 30
+#define MAX_CAPTURE_MS 100
+#define MAX_CAPTURE_EVENTS (MAX_HELD_NOTES * 2)
+#define RUNTIME_BLOB_MAGIC 0x54525545u /* "EURT" */
+#define RUNTIME_BLOB_VERSION 7
+#define RUNTIME_BLOB_MAX 4096
+#define PRESET_LIB_MAGIC 0x4c505545u /* "EUPL" */
+#define PRESET_LIB_VERSION 2
+#define PRESET_LIB_FILENAME "presets.eupl"
+#define PLAYHEAD_MAGIC 0x48505545u
+#define PLAYHEAD_VERSION 1
+#define PRESET_NAME_LEN 32
+#define PRESET_TAGS_LEN 24
+#define PRESET_HEADER_SIZE 24
+#define PRESET_INDEX_ENTRY_SIZE 64
+#define MAX_SONG_ENTRIES 64
+#define SONG_LIST_MAX 1024
+#define TAP_MAX_STEPS 64
+#define TAP_END_STEPS 8
+#ifndef EUCALYPSO_DEBUG_LOG
 #define EUCALYPSO_DEBUG_LOG 1
+#endif
 #define EUCALYPSO_LOG_PATH "/data/UserData/move-anything/eucalypso.log"
 
 typedef enum {
@@ -45,9 +88,21 @@ typedef enum {
 
 typedef enum {
     SYNC_INTERNAL = 0,
-    SYNC_CLOCK
+    SYNC_CLOCK,
+    SYNC_NOTE
 } sync_mode_t;
 
+typedef enum {
+    CATCHUP_ALL = 0,
+    CATCHUP_LATEST,
+    CATCHUP_SKIP
+} catchup_policy_t;
+
+typedef enum {
+    RAMP_LINEAR = 0,
+    RAMP_EXP
+} ramp_curve_t;
+
 typedef enum {
     RATE_1_32 = 0,
     RATE_1_16T,
@@ -97,6 +152,49 @@ typedef enum {
     SCALE_CHROMATIC
 } scale_mode_t;
 
+/*
+ * Shared playhead published for the UI (see playhead_publish). Native byte
+ * order; the UI maps the same file on the same device. seq is a seqlock
+ * counter: odd while the engine is writing. lanes are those of part 1;
+ * publishing other parts needs a new version of this layout.
+ */
+typedef struct {
+    uint64_t mask[2];
+    uint16_t steps;
+    uint16_t position;
+    uint8_t enabled;
+    uint8_t hit;
+    uint8_t last_note;
+    uint8_t last_velocity;
+    uint32_t reserved[2];
+} playhead_lane_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t lane_count;
+    uint32_t seq;
+    uint32_t running;
+    uint64_t anchor_step;
+    uint64_t flick_clock;
+    playhead_lane_t lanes[MAX_LANES];
+} playhead_t;
+
+_Static_assert(sizeof(playhead_t) == 160, "playhead layout is part of the UI contract");
+
+typedef enum {
+    CHAN_ALLOC_OFF = 0,
+    CHAN_ALLOC_ROUND_ROBIN,
+    CHAN_ALLOC_LRU
+} chan_alloc_t;
+
+typedef enum {
+    DIR_FORWARD = 0,
+    DIR_REVERSE,
+    DIR_PINGPONG,
+    DIR_RANDOM
+} direction_t;
+
 typedef struct {
     int enabled;
     int steps;
@@ -113,14 +211,73 @@ typedef struct {
     int oct_rng;
     int velocity;
     int gate;
+    int early_ms;
+    int direction;
+    int dir_seed;
+    int legato;
 } lane_t;
 
+/* Summed evolve offsets of one lane, relative to its stored settings. */
+typedef struct {
+    int pulses;
+    int rotation;
+    int drop;
+    uint64_t seed_cycle;
+} evolve_walk_t;
+
+/*
+ * A part is one set of lanes with its own note register settings and output
+ * channel. The parts of an instance share the transport, held keys, clock
+ * handling, voice pool and output buffer, so extra parts cost only their
+ * own lane evaluation. Part 1 is what the original parameters address.
+ */
+typedef struct {
+    register_mode_t register_mode;
+    held_order_t held_order;
+    int held_order_seed;
+    scale_mode_t scale_mode;
+    int scale_rng;
+    int root_note;
+    int octave;
+    missing_note_policy_t missing_note_policy;
+    int missing_note_seed;
+    /* 0 follows chan_mode, 1-16 pins the part to that channel. */
+    int out_chan;
+    lane_t lanes[MAX_LANES];
+    /* Evolved copy of each lane for its current cycle, keyed by the stored
+     * lane it was derived from. */
+    lane_t evolve_base[MAX_LANES];
+    lane_t evolve_lane[MAX_LANES];
+    uint64_t evolve_cycle[MAX_LANES];
+    int evolve_valid[MAX_LANES];
+
+    uint64_t legato_mask[MAX_LANES][LEGATO_MASK_WORDS];
+    int legato_period[MAX_LANES];
+    lane_t legato_key[MAX_LANES];
+    int legato_valid[MAX_LANES];
+} part_t;
+
+/* A song list as the audio thread walks it. A published list is never
+ * written again until it has been swapped out; gen changes with every
+ * publish and tells the audio thread to rewind. */
+typedef struct {
+    uint32_t gen;
+    int count;
+    int slot[MAX_SONG_ENTRIES];
+    int bars[MAX_SONG_ENTRIES];
+    int repeat[MAX_SONG_ENTRIES];
+    const uint8_t *block[MAX_SONG_ENTRIES];
+    int block_fields;
+} song_list_t;
+
 typedef struct {
     play_mode_t play_mode;
     retrigger_mode_t retrigger_mode;
     rate_t rate;
     sync_mode_t sync_mode;
     int bpm;
+    int ramp_beats;
+    ramp_curve_t ramp_curve;
     int swing;
     int max_voices;
     int global_velocity;
@@ -129,16 +286,13 @@ typedef struct {
     int global_g_rnd;
     int global_rnd_seed;
     int rand_cycle;
-    register_mode_t register_mode;
-    held_order_t held_order;
-    int held_order_seed;
-    scale_mode_t scale_mode;
-    int scale_rng;
-    int root_note;
-    int octave;
-    missing_note_policy_t missing_note_policy;
-    int missing_note_seed;
-    lane_t lanes[MAX_LANES];
+    int evolve;
+    int evolve_seed;
+    int rng_version;
+    part_t parts[MAX_PARTS];
+    int part_count;
+    /* Part addressed by unprefixed lane and register parameters. */
+    int part_edit;
 
     uint8_t physical_notes[MAX_HELD_NOTES];
     int physical_count;
@@ -152,11 +306,13 @@ typedef struct {
 
     int sample_rate;
     int timing_dirty;
-    int step_interval_base;
-    int samples_until_step;
-    double step_interval_base_f;
-    double samples_until_step_f;
-    uint64_t internal_sample_total;
+    /* Internal time is kept in flicks (1/705600000 s), which divide evenly by
+     * all common sample rates, so a rate change does not move any phase. */
+    int flick_rate;
+    uint64_t flick_remainder;
+    double step_interval_flicks;
+    double flicks_until_step;
+    uint64_t internal_flicks;
     int swing_phase;
 
     int clock_counter;
@@ -169,6 +325,32 @@ typedef struct {
     uint64_t clock_tick_total;
     int pending_step_triggers;
 
+    uint64_t flick_clock;
+    uint64_t clock_stamp_flicks;
+    int clock_stamp_valid;
+    int clock_ticks_since_stamp;
+    double clock_interval_f;
+    int clock_loss_mult;
+    int clock_lost;
+
+    int trig_note;
+    int trig_chan;
+    int trig_stamp_valid;
+    uint64_t trig_stamp_flicks;
+    double trig_interval_f;
+
+    catchup_policy_t catchup_policy;
+    int catchup_ms;
+    int early_ms;
+    double early_lead_flicks;
+    int capture_ms;
+    uint8_t capture_events[MAX_CAPTURE_EVENTS];
+    int capture_count;
+    uint64_t capture_deadline;
+    uint64_t last_tick_flicks;
+    int backlog_depth_peak;
+    uint64_t backlog_skipped;
+
     uint64_t anchor_step;
     uint64_t phrase_anchor_step;
     int phrase_restart_pending;
@@ -176,10 +358,76 @@ typedef struct {
     uint64_t preview_step_id;
 
     uint8_t voice_notes[MAX_VOICES];
+    uint8_t voice_chan[MAX_VOICES];
     int voice_clock_left[MAX_VOICES];
-    int voice_sample_left[MAX_VOICES];
+    int64_t voice_time_left[MAX_VOICES];
     int voice_count;
 
+    /* Output channel allocation: voices per channel, a bitmask of channels
+     * with any voice, and release stamps for least-recently-used picks. */
+    int chan_mode;
+    int chan_lo;
+    int chan_hi;
+    int chan_next;
+    uint8_t chan_voices[16];
+    uint32_t chan_busy;
+    uint32_t chan_stamp[16];
+    uint32_t chan_clock;
+
+    /* Notes evaluated ahead of time, waiting for their emission time on
+     * flick_clock. */
+    uint64_t pending_at[MAX_PENDING_NOTES];
+    uint8_t pending_note[MAX_PENDING_NOTES];
+    uint8_t pending_velocity[MAX_PENDING_NOTES];
+    int pending_gate[MAX_PENDING_NOTES];
+    uint8_t pending_chan[MAX_PENDING_NOTES];
+    int pending_count;
+
+    char preset_name[PRESET_NAME_LEN];
+
+    int song_mode;
+    /* song_list points at one of song_lists; set_param fills the other and
+     * swaps the pointer. song_busy is set while the audio thread walks it. */
+    song_list_t song_lists[2];
+    song_list_t *song_list;
+    int song_busy;
+    uint32_t song_seen_gen;
+    int song_entry;
+    int song_repeat_left;
+    int song_steps_left;
+    int song_retimed;
+
+    int ramp_active;
+    double ramp_from_bpm;
+    double ramp_to_bpm;
+    double ramp_length_beats;
+    double ramp_beat;
+
+    int tap_lane;
+    int tap_count;
+    uint64_t tap_first_step;
+    uint64_t tap_mask;
+    int tap_last_rel;
+    int tap_fit_steps;
+    int tap_fit_pulses;
+    int tap_fit_rotation;
+    int tap_fit_distance;
+
+    /* Swapped by set_param, read by the audio thread while playhead_busy.
+     * playhead_gen counts completed swaps. */
+    playhead_t *playhead;
+    int playhead_busy;
+    uint32_t playhead_gen;
+    char playhead_name[128];
+    uint8_t playhead_hit[MAX_LANES];
+    uint8_t playhead_note[MAX_LANES];
+    uint8_t playhead_velocity[MAX_LANES];
+    /* Audio thread only: per-lane mask cache keyed on steps/pulses/rotation,
+     * and the swap generation the cached masks were last copied under. */
+    uint64_t playhead_mask[MAX_LANES][2];
+    int playhead_mask_key[MAX_LANES][3];
+    uint32_t playhead_written_gen;
+
     FILE *debug_fp;
     uint64_t debug_seq;
 
@@ -187,6 +435,11 @@ typedef struct {
     int chain_params_len;
 } eucalypso_instance_t;
 
+/* Preset library location, captured from the first instance's module dir.
+ * Tried once; a missing library is not looked up again on every recall. */
+static char g_preset_lib_default_path[512];
+static int g_preset_lib_default_tried;
+
 typedef struct {
     const int *intervals;
     int count;
@@ -236,6 +489,9 @@ static int eucalypso_get_sync_warning(eucalypso_instance_t *inst, char *buf, int
     if (status == MOVE_CLOCK_STATUS_STOPPED) {
         return snprintf(buf, buf_len, "Clock out enabled, transport stopped");
     }
+    if (inst->clock_lost) {
+        return snprintf(buf, buf_len, "MIDI clock lost, releasing notes");
+    }
 
     buf[0] = '\0';
     return 0;
@@ -317,12 +573,99 @@ static uint32_t global_lane_seed(const eucalypso_instance_t *inst, int lane_idx,
     return seed + (uint32_t)((lane_idx + 1) * 1000) + offset;
 }
 
-static uint32_t missing_note_seed(const eucalypso_instance_t *inst, int lane_idx) {
+static uint32_t missing_note_seed(const part_t *part, int lane_idx) {
     uint32_t seed = 1u;
-    if (inst) seed = (uint32_t)(inst->missing_note_seed + 1);
+    if (part) seed = (uint32_t)(part->missing_note_seed + 1);
     return seed + (uint32_t)((lane_idx + 1) * 1000) + 0x6000u;
 }
 
+/*
+ * Per-step random words for one lane.
+ *
+ * rng_version 1 reproduces the original per-decision step_rand_u32 calls
+ * bit for bit, so states saved before rng_version existed play unchanged.
+ * Version 2 is counter based: the counter is (cycle step, lane, word) and
+ * each word is one 64-bit finalizer over the counter and that word's own
+ * seed. That is a single multiply pair per word instead of two 32-bit mixes,
+ * with a 64-bit state throughout. Each word still depends only on its own
+ * seed, so editing the note seed does not move drops.
+ *
+ * Under either version a word is only computed when its feature is on;
+ * the words of disabled features are left at 0 and never read.
+ */
+enum {
+    RAND_DROP = 0,
+    RAND_NOTE,
+    RAND_OCTAVE,
+    RAND_VELOCITY,
+    RAND_GATE,
+    RAND_MISSING,
+    RAND_WORDS
+};
+
+typedef struct {
+    uint32_t w[RAND_WORDS];
+} step_rand_t;
+
+static uint64_t mix_u64(uint64_t x) {
+    x ^= x >> 32;
+    x *= 0xd6e8feb86659fd93ull;
+    x ^= x >> 32;
+    x *= 0xd6e8feb86659fd93ull;
+    x ^= x >> 32;
+    return x;
+}
+
+static void lane_step_rand(const eucalypso_instance_t *inst, const part_t *part, const lane_t *lane,
+                           int lane_idx, uint64_t rhythm_step, step_rand_t *out) {
+    uint64_t cycle_step = rand_cycle_step(inst, rhythm_step);
+    unsigned need = 0;
+    if (lane->drop > 0) need |= 1u << RAND_DROP;
+    if (lane->n_rnd > 0) need |= 1u << RAND_NOTE;
+    if (lane->oct_rnd > 0) need |= 1u << RAND_OCTAVE;
+    if (inst->global_v_rnd > 0) need |= 1u << RAND_VELOCITY;
+    if (inst->global_g_rnd > 0) need |= 1u << RAND_GATE;
+    if (part->missing_note_policy == MISSING_RANDOM) need |= 1u << RAND_MISSING;
+    memset(out, 0, sizeof(*out));
+    if (!need) return;
+    if (inst->rng_version >= 2) {
+        uint32_t seeds[RAND_WORDS];
+        uint64_t ctr = cycle_step * 0x9e3779b97f4a7c15ull + ((uint64_t)(lane_idx + 1) << 56);
+        int i;
+        seeds[RAND_DROP] = (uint32_t)lane->drop_seed;
+        seeds[RAND_NOTE] = (uint32_t)lane->n_seed;
+        seeds[RAND_OCTAVE] = (uint32_t)lane->oct_seed;
+        seeds[RAND_VELOCITY] = (uint32_t)inst->global_rnd_seed;
+        seeds[RAND_GATE] = (uint32_t)inst->global_rnd_seed;
+        seeds[RAND_MISSING] = (uint32_t)part->missing_note_seed;
+        for (i = 0; i < RAND_WORDS; i++) {
+            uint64_t key;
+            if (!(need & (1u << i))) continue;
+            key = ((uint64_t)seeds[i] << 32) | (uint32_t)(i + 1);
+            out->w[i] = (uint32_t)(mix_u64(ctr ^ (key * 0xbf58476d1ce4e5b9ull)) >> 32);
+        }
+        return;
+    }
+    if (need & (1u << RAND_DROP)) {
+        out->w[RAND_DROP] = step_rand_u32((uint32_t)(lane->drop_seed + 1), cycle_step, 0x1000u + (uint32_t)lane_idx);
+    }
+    if (need & (1u << RAND_NOTE)) {
+        out->w[RAND_NOTE] = step_rand_u32((uint32_t)(lane->n_seed + 1), cycle_step, 0x2000u + (uint32_t)lane_idx);
+    }
+    if (need & (1u << RAND_OCTAVE)) {
+        out->w[RAND_OCTAVE] = step_rand_u32((uint32_t)(lane->oct_seed + 1), cycle_step, 0x3000u + (uint32_t)lane_idx);
+    }
+    if (need & (1u << RAND_VELOCITY)) {
+        out->w[RAND_VELOCITY] = step_rand_u32(global_lane_seed(inst, lane_idx, 0x4000u), cycle_step, 0x4000u);
+    }
+    if (need & (1u << RAND_GATE)) {
+        out->w[RAND_GATE] = step_rand_u32(global_lane_seed(inst, lane_idx, 0x5000u), cycle_step, 0x5000u);
+    }
+    if (need & (1u << RAND_MISSING)) {
+        out->w[RAND_MISSING] = step_rand_u32(missing_note_seed(part, lane_idx), cycle_step, 0x6000u);
+    }
+}
+
 static uint32_t active_note_hash(const eucalypso_instance_t *inst) {
     uint32_t h = 2166136261u;
     int i;
@@ -501,8 +844,6 @@ static void note_on(eucalypso_instance_t *inst, uint8_t note) {
             dlog(inst, "phrase restart armed latch-replace anchor=%llu",
                  (unsigned long long)inst->anchor_step);
         }
-    } else {
-        sync_active_to_physical(inst);
     }
 }
 
@@ -510,11 +851,59 @@ static void note_off(eucalypso_instance_t *inst, uint8_t note) {
     if (!inst) return;
     arr_remove(inst->physical_notes, &inst->physical_count, note);
     arr_remove(inst->physical_as_played, &inst->physical_as_played_count, note);
-    if (inst->play_mode == PLAY_LATCH) {
-        if (inst->physical_count == 0) inst->latch_ready_replace = 1;
-    } else {
-        sync_active_to_physical(inst);
+    if (inst->play_mode == PLAY_LATCH && inst->physical_count == 0) inst->latch_ready_replace = 1;
+}
+
+/* note_on/note_off only touch the physical set in hold mode; the active
+ * register is rebuilt once after a key event or a captured burst. */
+static void settle_register(eucalypso_instance_t *inst, int live_before) {
+    if (!inst) return;
+    if (inst->play_mode == PLAY_HOLD) sync_active_to_physical(inst);
+    if (live_before == 0 && inst->active_count > 0) {
+        inst->suppress_initial_note_restart = 0;
+        if (inst->retrigger_mode == RETRIG_RESTART) {
+            inst->phrase_restart_pending = 1;
+            dlog(inst, "phrase restart armed anchor=%llu",
+                 (unsigned long long)inst->anchor_step);
+        }
+    }
+}
+
+/*
+ * With capture_ms > 0, key events are queued for that long after the first
+ * one and then applied together, so a chord played as a burst of note-ons
+ * rebuilds the register and arms a phrase restart once, and no step sees
+ * half of it. Bit 7 of a queued event marks a note-on.
+ */
+static void capture_commit(eucalypso_instance_t *inst) {
+    int live_before;
+    int i;
+    if (!inst || inst->capture_count <= 0) return;
+    live_before = inst->active_count;
+    for (i = 0; i < inst->capture_count; i++) {
+        uint8_t ev = inst->capture_events[i];
+        if (ev & 0x80) note_on(inst, ev & 0x7F);
+        else note_off(inst, ev & 0x7F);
+    }
+    dlog(inst, "capture commit events=%d anchor=%llu", inst->capture_count,
+         (unsigned long long)inst->anchor_step);
+    inst->capture_count = 0;
+    settle_register(inst, live_before);
+}
+
+static void capture_poll(eucalypso_instance_t *inst) {
+    if (inst && inst->capture_count > 0 && inst->flick_clock >= inst->capture_deadline) capture_commit(inst);
+}
+
+static void capture_note_event(eucalypso_instance_t *inst, uint8_t note, int on) {
+    if (!inst) return;
+    capture_poll(inst);
+    if (inst->capture_count >= MAX_CAPTURE_EVENTS) capture_commit(inst);
+    if (inst->capture_count == 0) {
+        inst->capture_deadline = inst->flick_clock +
+                                 (uint64_t)inst->capture_ms * (FLICKS_PER_SECOND / 1000ull);
     }
+    inst->capture_events[inst->capture_count++] = (uint8_t)((note & 0x7F) | (on ? 0x80 : 0x00));
 }
 
 static uint64_t rhythm_step_id(const eucalypso_instance_t *inst, uint64_t anchor_step) {
@@ -546,16 +935,16 @@ static scale_def_t get_scale_def(scale_mode_t mode) {
     }
 }
 
-static int build_scale_register(const eucalypso_instance_t *inst, int *notes, int max_notes) {
+static int build_scale_register(const part_t *part, int *notes, int max_notes) {
     int i;
     int count;
     int base;
     scale_def_t scale;
-    if (!inst || !notes || max_notes <= 0) return 0;
-    scale = get_scale_def(inst->scale_mode);
-    count = clamp_int(inst->scale_rng, 1, MAX_REGISTER_NOTES);
+    if (!part || !notes || max_notes <= 0) return 0;
+    scale = get_scale_def(part->scale_mode);
+    count = clamp_int(part->scale_rng, 1, MAX_REGISTER_NOTES);
     if (count > max_notes) count = max_notes;
-    base = SCALE_BASE_NOTE + clamp_int(inst->root_note, 0, 11);
+    base = SCALE_BASE_NOTE + clamp_int(part->root_note, 0, 11);
     for (i = 0; i < count; i++) {
         int degree = i % scale.count;
         int oct = i / scale.count;
@@ -564,11 +953,11 @@ static int build_scale_register(const eucalypso_instance_t *inst, int *notes, in
     return count;
 }
 
-static int build_drumpad_register(const eucalypso_instance_t *inst, int *notes, int max_notes) {
+static int build_drumpad_register(const part_t *part, int *notes, int max_notes) {
     int i;
     int count;
-    if (!inst || !notes || max_notes <= 0) return 0;
-    count = clamp_int(inst->scale_rng, 1, DRUMPAD_COUNT);
+    if (!part || !notes || max_notes <= 0) return 0;
+    count = clamp_int(part->scale_rng, 1, DRUMPAD_COUNT);
     if (count > max_notes) count = max_notes;
     for (i = 0; i < count; i++) {
         notes[i] = DRUMPAD_BASE_NOTE + i;
@@ -587,7 +976,7 @@ static void shuffle_notes(int *notes, int count, uint32_t seed) {
     }
 }
 
-static int build_held_register(const eucalypso_instance_t *inst, int *notes, int max_notes) {
+static int build_held_register(const eucalypso_instance_t *inst, const part_t *part, int *notes, int max_notes) {
     int i;
     int count;
     if (!inst || !notes || max_notes <= 0) return 0;
@@ -595,7 +984,7 @@ static int build_held_register(const eucalypso_instance_t *inst, int *notes, int
     if (count > max_notes) count = max_notes;
     if (count <= 0) return 0;
 
-    if (inst->held_order == HELD_PLAYED && inst->active_as_played_count > 0) {
+    if (part->held_order == HELD_PLAYED && inst->active_as_played_count > 0) {
         int out = 0;
         for (i = 0; i < inst->active_as_played_count && out < count; i++) {
             uint8_t note = inst->active_as_played[i];
@@ -606,7 +995,7 @@ static int build_held_register(const eucalypso_instance_t *inst, int *notes, int
         return out;
     }
 
-    if (inst->held_order == HELD_DOWN) {
+    if (part->held_order == HELD_DOWN) {
         for (i = 0; i < count; i++) {
             notes[i] = inst->active_notes[count - 1 - i];
         }
@@ -614,27 +1003,27 @@ static int build_held_register(const eucalypso_instance_t *inst, int *notes, int
     }
 
     for (i = 0; i < count; i++) notes[i] = inst->active_notes[i];
-    if (inst->held_order == HELD_RAND) {
-        shuffle_notes(notes, count, (uint32_t)inst->held_order_seed ^ active_note_hash(inst));
+    if (part->held_order == HELD_RAND) {
+        shuffle_notes(notes, count, (uint32_t)part->held_order_seed ^ active_note_hash(inst));
     }
     return count;
 }
 
-static int build_register(const eucalypso_instance_t *inst, int *notes, int max_notes) {
-    if (!inst || !notes || max_notes <= 0) return 0;
-    if (inst->register_mode == REGISTER_DRUMPAD) {
-        return build_drumpad_register(inst, notes, max_notes);
+static int build_register(const eucalypso_instance_t *inst, const part_t *part, int *notes, int max_notes) {
+    if (!inst || !part || !notes || max_notes <= 0) return 0;
+    if (part->register_mode == REGISTER_DRUMPAD) {
+        return build_drumpad_register(part, notes, max_notes);
     }
-    if (inst->register_mode == REGISTER_SCALE) {
-        return build_scale_register(inst, notes, max_notes);
+    if (part->register_mode == REGISTER_SCALE) {
+        return build_scale_register(part, notes, max_notes);
     }
-    return build_held_register(inst, notes, max_notes);
+    return build_held_register(inst, part, notes, max_notes);
 }
 
-static int lane_gate_enabled_for_step(const eucalypso_instance_t *inst, int lane_idx) {
+static int lane_gate_enabled_for_step(const eucalypso_instance_t *inst, const part_t *part, int lane_idx) {
     int gate_note;
-    if (!inst) return 0;
-    if (inst->register_mode != REGISTER_DRUMPAD) return 1;
+    if (!inst || !part) return 0;
+    if (part->register_mode != REGISTER_DRUMPAD) return 1;
     gate_note = DRUMPAD_BASE_NOTE + clamp_int(lane_idx, 0, MAX_LANES - 1);
     return arr_contains(inst->active_notes, inst->active_count, (uint8_t)gate_note);
 }
@@ -687,12 +1076,11 @@ static int fold_index(int idx, int count) {
     return idx;
 }
 
-static int resolve_register_index(const eucalypso_instance_t *inst, int lane_idx,
-                                  int requested_idx, int reg_count, uint64_t rhythm_step) {
-    uint64_t cycle_step;
+static int resolve_register_index(const part_t *part, int requested_idx, int reg_count,
+                                  const step_rand_t *rw) {
     if (reg_count <= 0) return -1;
     if (requested_idx >= 0 && requested_idx < reg_count) return requested_idx;
-    switch (inst ? inst->missing_note_policy : MISSING_SKIP) {
+    switch (part ? part->missing_note_policy : MISSING_SKIP) {
         case MISSING_FOLD:
             return fold_index(requested_idx, reg_count);
         case MISSING_WRAP: {
@@ -700,46 +1088,40 @@ static int resolve_register_index(const eucalypso_instance_t *inst, int lane_idx
             if (idx < 0) idx += reg_count;
             return idx;
         }
-        case MISSING_RANDOM: {
-            uint32_t r;
-            cycle_step = rand_cycle_step(inst, rhythm_step);
-            r = step_rand_u32(missing_note_seed(inst, lane_idx), cycle_step, 0x6000u);
-            return (int)(r % (uint32_t)reg_count);
-        }
+        case MISSING_RANDOM:
+            return (int)(rw->w[RAND_MISSING] % (uint32_t)reg_count);
         case MISSING_SKIP:
         default:
             return -1;
     }
 }
 
-static int select_lane_note(const eucalypso_instance_t *inst, const lane_t *lane,
-                            int lane_idx, uint64_t rhythm_step) {
+static int select_lane_note(const eucalypso_instance_t *inst, const part_t *part, const lane_t *lane,
+                            const step_rand_t *rw) {
     int register_notes[MAX_REGISTER_NOTES];
     int reg_count;
     int idx;
     int base_idx;
     int note;
-    uint64_t cycle_step;
-    if (!inst || !lane) return -1;
-    reg_count = build_register(inst, register_notes, MAX_REGISTER_NOTES);
+    if (!inst || !part || !lane) return -1;
+    reg_count = build_register(inst, part, register_notes, MAX_REGISTER_NOTES);
     if (reg_count <= 0) return -1;
-    cycle_step = rand_cycle_step(inst, rhythm_step);
     base_idx = clamp_int(lane->note, 1, MAX_REGISTER_NOTES) - 1;
-    base_idx = resolve_register_index(inst, lane_idx, base_idx, reg_count, rhythm_step);
+    base_idx = resolve_register_index(part, base_idx, reg_count, rw);
     if (base_idx < 0) return -1;
     idx = base_idx;
     if (lane->n_rnd > 0 && reg_count > 1) {
-        uint32_t r = step_rand_u32((uint32_t)(lane->n_seed + 1), cycle_step, 0x2000u + (uint32_t)lane_idx);
+        uint32_t r = rw->w[RAND_NOTE];
         if (chance_hit(r, lane->n_rnd)) {
             idx = (int)((r >> 8) % (uint32_t)(reg_count - 1));
             if (idx >= base_idx) idx++;
         }
     }
     note = register_notes[idx];
-    note += clamp_int(inst->octave, -3, 3) * 12;
+    note += clamp_int(part->octave, -3, 3) * 12;
     note += clamp_int(lane->octave, -3, 3) * 12;
     if (lane->oct_rnd > 0) {
-        uint32_t r = step_rand_u32((uint32_t)(lane->oct_seed + 1), cycle_step, 0x3000u + (uint32_t)lane_idx);
+        uint32_t r = rw->w[RAND_OCTAVE];
         if (chance_hit(r, lane->oct_rnd)) {
             int count = octave_offset_count(lane->oct_rng);
             int pick = (int)((r >> 8) % (uint32_t)count);
@@ -764,7 +1146,24 @@ static const char *rate_to_string(rate_t rate) {
     }
 }
 
+static const char *chan_mode_to_string(int mode) {
+    if (mode == CHAN_ALLOC_ROUND_ROBIN) return "rr";
+    if (mode == CHAN_ALLOC_LRU) return "lru";
+    return "off";
+}
+
+static const char *direction_to_string(int direction) {
+    switch (direction) {
+        case DIR_REVERSE: return "rev";
+        case DIR_PINGPONG: return "pingpong";
+        case DIR_RANDOM: return "rand";
+        case DIR_FORWARD:
+        default: return "fwd";
+    }
+}
+
 static const char *sync_to_string(sync_mode_t mode) {
+    if (mode == SYNC_NOTE) return "note";
     return mode == SYNC_CLOCK ? "clock" : "internal";
 }
 
@@ -861,33 +1260,128 @@ static void recalc_clock_timing(eucalypso_instance_t *inst) {
     inst->clocks_per_step = clocks;
 }
 
-static void recalc_internal_timing(eucalypso_instance_t *inst, int sample_rate) {
+/* Converts a block of frames to flicks. The division remainder is carried
+ * between blocks so the running total stays exact at any rate. */
+static uint64_t frames_to_flicks(eucalypso_instance_t *inst, int frames, int sample_rate) {
+    uint64_t num;
+    uint64_t flicks;
+    if (sample_rate <= 0 || frames <= 0) return 0;
+    if (inst->flick_rate != sample_rate) {
+        inst->flick_rate = sample_rate;
+        inst->flick_remainder = 0;
+    }
+    num = (uint64_t)frames * FLICKS_PER_SECOND + inst->flick_remainder;
+    flicks = num / (uint64_t)sample_rate;
+    inst->flick_remainder = num % (uint64_t)sample_rate;
+    return flicks;
+}
+
+/* Updates the step interval only; the running phase is left alone. */
+static void recalc_internal_interval(eucalypso_instance_t *inst) {
     double npb;
-    double step_samples;
-    if (!inst || sample_rate <= 0) return;
+    if (!inst) return;
     inst->bpm = clamp_int(inst->bpm, 40, 240);
     npb = rate_notes_per_beat(inst->rate);
     if (npb <= 0.0) npb = 4.0;
-    step_samples = ((double)sample_rate * 60.0) / ((double)inst->bpm * npb);
-    if (step_samples < 1.0) step_samples = 1.0;
+    inst->step_interval_flicks = ((double)FLICKS_PER_SECOND * 60.0) / ((double)inst->bpm * npb);
+}
+
+/* The sample rate only converts block lengths into flicks, so changing it
+ * leaves the step interval and the running phase untouched. */
+static void recalc_internal_timing(eucalypso_instance_t *inst, int sample_rate) {
+    if (!inst || sample_rate <= 0) return;
     inst->sample_rate = sample_rate;
-    inst->step_interval_base_f = step_samples;
-    inst->step_interval_base = (int)(step_samples + 0.5);
-    if (inst->step_interval_base < 1) inst->step_interval_base = 1;
-    if (inst->samples_until_step_f <= 0.0 || inst->samples_until_step_f > inst->step_interval_base_f) {
-        inst->samples_until_step_f = inst->step_interval_base_f;
-    }
-    inst->samples_until_step = (int)(inst->samples_until_step_f + 0.5);
-    if (inst->samples_until_step < 1) inst->samples_until_step = 1;
+    recalc_internal_interval(inst);
+    if (inst->flicks_until_step < 0.0 || inst->flicks_until_step > inst->step_interval_flicks) {
+        inst->flicks_until_step = inst->step_interval_flicks;
+    }
     inst->timing_dirty = 0;
 }
 
+/*
+ * Tempo ramps.
+ *
+ * A ramp runs from ramp_from_bpm to ramp_to_bpm over ramp_length_beats,
+ * starting at the next step boundary. Tempo is linear or exponential in
+ * beat position, so elapsed time has a closed form:
+ *
+ *   linear:      t(b) = 60 N / (T1 - T0) * ln(T(b) / T0)
+ *   exponential: t(b) = 60 N / (T0 ln r) * (1 - r^(-b/N)),  r = T1 / T0
+ *
+ * Each step interval is t(b + step) - t(b) evaluated from the ramp start,
+ * so boundaries stay exact at any block size and sample rate and there is no
+ * per-block tempo update.
+ */
+static const char *ramp_curve_to_string(ramp_curve_t curve) {
+    return curve == RAMP_EXP ? "exp" : "lin";
+}
+
+static double ramp_tempo_at(const eucalypso_instance_t *inst, double beat) {
+    double t0 = inst->ramp_from_bpm;
+    double t1 = inst->ramp_to_bpm;
+    double x;
+    if (beat >= inst->ramp_length_beats) return t1;
+    x = beat / inst->ramp_length_beats;
+    if (inst->ramp_curve == RAMP_EXP) return t0 * pow(t1 / t0, x);
+    return t0 + (t1 - t0) * x;
+}
+
+static double ramp_seconds_to(const eucalypso_instance_t *inst, double beat) {
+    double t0 = inst->ramp_from_bpm;
+    double t1 = inst->ramp_to_bpm;
+    double n = inst->ramp_length_beats;
+    if (beat <= 0.0) return 0.0;
+    if (beat > n) return ramp_seconds_to(inst, n) + (beat - n) * 60.0 / t1;
+    if (fabs(t1 - t0) < 1e-9) return beat * 60.0 / t0;
+    if (inst->ramp_curve == RAMP_EXP) {
+        double r = t1 / t0;
+        return (60.0 * n / (t0 * log(r))) * (1.0 - pow(r, -beat / n));
+    }
+    return (60.0 * n / (t1 - t0)) * log(ramp_tempo_at(inst, beat) / t0);
+}
+
+static double current_tempo(const eucalypso_instance_t *inst) {
+    if (inst->ramp_active) return ramp_tempo_at(inst, inst->ramp_beat);
+    return (double)inst->bpm;
+}
+
+static void start_tempo_ramp(eucalypso_instance_t *inst, double from_bpm) {
+    inst->ramp_from_bpm = from_bpm;
+    inst->ramp_to_bpm = (double)inst->bpm;
+    inst->ramp_length_beats = (double)inst->ramp_beats;
+    inst->ramp_beat = 0.0;
+    inst->ramp_active = 1;
+}
+
+static void end_tempo_ramp(eucalypso_instance_t *inst) {
+    if (!inst->ramp_active) return;
+    inst->ramp_active = 0;
+    recalc_internal_interval(inst);
+}
+
+/* Length in flicks of the step starting at the current ramp position. */
+static double ramp_next_interval(eucalypso_instance_t *inst) {
+    double step_beats = 1.0 / rate_notes_per_beat(inst->rate);
+    double from = inst->ramp_beat;
+    double interval = (ramp_seconds_to(inst, from + step_beats) - ramp_seconds_to(inst, from)) *
+                      (double)FLICKS_PER_SECOND;
+    inst->ramp_beat = from + step_beats;
+    if (inst->ramp_beat >= inst->ramp_length_beats) {
+        end_tempo_ramp(inst);
+    } else {
+        inst->step_interval_flicks = interval;
+    }
+    return interval;
+}
+
 static double next_internal_interval(eucalypso_instance_t *inst) {
     double base;
     double delta;
     int swing;
     if (!inst) return 1.0;
-    base = inst->step_interval_base_f > 0.0 ? inst->step_interval_base_f : 1.0;
+    if (inst->ramp_active) base = ramp_next_interval(inst);
+    else base = inst->step_interval_flicks > 0.0 ? inst->step_interval_flicks : 1.0;
+    if (base < 1.0) base = 1.0;
     swing = clamp_int(inst->swing, 0, 100);
     if (swing <= 0) return base;
     delta = (base * (double)swing) / 200.0;
@@ -908,30 +1402,31 @@ static void realign_clock_phase(eucalypso_instance_t *inst) {
 
 static void realign_internal_phase(eucalypso_instance_t *inst) {
     double interval;
-    double total;
     double rem;
     double until_next;
     if (!inst) return;
-    interval = inst->step_interval_base_f > 0.0 ? inst->step_interval_base_f : 1.0;
-    total = (double)inst->internal_sample_total;
-    rem = total;
-    while (rem >= interval) rem -= interval;
-    while (rem < 0.0) rem += interval;
+    interval = inst->step_interval_flicks > 0.0 ? inst->step_interval_flicks : 1.0;
+    rem = fmod((double)inst->internal_flicks, interval);
     until_next = rem < 1e-9 ? interval : interval - rem;
     if (until_next < 1.0) until_next = 1.0;
-    inst->samples_until_step_f = until_next;
-    inst->samples_until_step = (int)(until_next + 0.5);
-    if (inst->samples_until_step < 1) inst->samples_until_step = 1;
+    inst->flicks_until_step = until_next;
     inst->swing_phase = 0;
 }
 
 static void voice_remove_at(eucalypso_instance_t *inst, int idx) {
     int i;
+    int chan;
     if (!inst || idx < 0 || idx >= inst->voice_count) return;
+    chan = inst->voice_chan[idx] & 0x0F;
+    if (inst->chan_voices[chan] > 0 && --inst->chan_voices[chan] == 0) {
+        inst->chan_busy &= ~(1u << chan);
+        inst->chan_stamp[chan] = ++inst->chan_clock;
+    }
     for (i = idx; i < inst->voice_count - 1; i++) {
         inst->voice_notes[i] = inst->voice_notes[i + 1];
+        inst->voice_chan[i] = inst->voice_chan[i + 1];
         inst->voice_clock_left[i] = inst->voice_clock_left[i + 1];
-        inst->voice_sample_left[i] = inst->voice_sample_left[i + 1];
+        inst->voice_time_left[i] = inst->voice_time_left[i + 1];
     }
     inst->voice_count--;
 }
@@ -941,7 +1436,7 @@ static int voice_note_off(eucalypso_instance_t *inst, int idx,
     uint8_t note;
     if (!inst || idx < 0 || idx >= inst->voice_count) return 0;
     note = inst->voice_notes[idx];
-    if (!emit3(out_msgs, out_lens, max_out, count, 0x80, note, 0)) return 0;
+    if (!emit3(out_msgs, out_lens, max_out, count, (uint8_t)(0x80 | inst->voice_chan[idx]), note, 0)) return 0;
     voice_remove_at(inst, idx);
     return 1;
 }
@@ -957,13 +1452,14 @@ static int flush_all_voices(eucalypso_instance_t *inst,
     return emitted;
 }
 
-static int kill_voice_notes(eucalypso_instance_t *inst, uint8_t note,
+/* Ends voices playing note; chan >= 0 limits it to that 0-based channel. */
+static int kill_voice_notes(eucalypso_instance_t *inst, uint8_t note, int chan,
                             uint8_t out_msgs[][3], int out_lens[], int max_out, int *count) {
     int i = 0;
     int killed = 0;
     if (!inst || !count) return 0;
     while (i < inst->voice_count) {
-        if (inst->voice_notes[i] == note) {
+        if (inst->voice_notes[i] == note && (chan < 0 || inst->voice_chan[i] == chan)) {
             if (!voice_note_off(inst, i, out_msgs, out_lens, max_out, count)) break;
             killed++;
         } else {
@@ -973,22 +1469,32 @@ static int kill_voice_notes(eucalypso_instance_t *inst, uint8_t note,
     return killed;
 }
 
-static void voice_add(eucalypso_instance_t *inst, uint8_t note, int gate_pct) {
+static void voice_add(eucalypso_instance_t *inst, uint8_t note, uint8_t chan, int gate_pct) {
     int idx;
     if (!inst || inst->voice_count >= MAX_VOICES) return;
     idx = inst->voice_count++;
     inst->voice_notes[idx] = note;
+    inst->voice_chan[idx] = chan;
+    inst->chan_voices[chan]++;
+    inst->chan_busy |= 1u << chan;
     inst->voice_clock_left[idx] = 0;
-    inst->voice_sample_left[idx] = 0;
-    gate_pct = clamp_int(gate_pct, 0, 1600);
+    inst->voice_time_left[idx] = 0;
+    gate_pct = clamp_int(gate_pct, 0, MAX_VOICE_GATE_PCT);
     if (inst->sync_mode == SYNC_CLOCK) {
         int clocks = (inst->clocks_per_step * gate_pct) / 100;
         if (clocks < 1) clocks = 1;
         inst->voice_clock_left[idx] = clocks;
+        if (inst->clock_lost) {
+            int64_t flicks = (int64_t)((double)clocks * inst->clock_interval_f + 0.5);
+            inst->voice_clock_left[idx] = 0;
+            inst->voice_time_left[idx] = flicks < 1 ? 1 : flicks;
+        }
     } else {
-        int samples = (inst->step_interval_base * gate_pct) / 100;
-        if (samples < 1) samples = 1;
-        inst->voice_sample_left[idx] = samples;
+        double interval = inst->step_interval_flicks;
+        int64_t flicks;
+        if (inst->sync_mode == SYNC_NOTE && inst->trig_interval_f > 0.0) interval = inst->trig_interval_f;
+        flicks = (int64_t)((interval * (double)gate_pct) / 100.0);
+        inst->voice_time_left[idx] = flicks < 1 ? 1 : flicks;
     }
 }
 
@@ -1009,14 +1515,14 @@ static int advance_voice_timers_clock(eucalypso_instance_t *inst,
     return emitted;
 }
 
-static int advance_voice_timers_samples(eucalypso_instance_t *inst, int frames,
-                                        uint8_t out_msgs[][3], int out_lens[], int max_out, int *count) {
+static int advance_voice_timers_flicks(eucalypso_instance_t *inst, uint64_t elapsed,
+                                       uint8_t out_msgs[][3], int out_lens[], int max_out, int *count) {
     int i = 0;
     int emitted = 0;
     if (!inst || !count) return 0;
     while (i < inst->voice_count) {
-        if (inst->voice_sample_left[i] > 0) inst->voice_sample_left[i] -= frames;
-        if (inst->voice_sample_left[i] <= 0) {
+        if (inst->voice_time_left[i] > 0) inst->voice_time_left[i] -= (int64_t)elapsed;
+        if (inst->voice_time_left[i] <= 0) {
             if (!voice_note_off(inst, i, out_msgs, out_lens, max_out, count)) break;
             emitted++;
         } else {
@@ -1026,28 +1532,261 @@ static int advance_voice_timers_samples(eucalypso_instance_t *inst, int frames,
     return emitted;
 }
 
-static int schedule_note(eucalypso_instance_t *inst, int note, int velocity, int gate_pct,
+static void clock_gates_to_flicks(eucalypso_instance_t *inst) {
+    int i;
+    double interval;
+    if (!inst) return;
+    interval = inst->clock_interval_f > 0.0 ? inst->clock_interval_f : 1.0;
+    for (i = 0; i < inst->voice_count; i++) {
+        int64_t flicks = (int64_t)((double)inst->voice_clock_left[i] * interval + 0.5);
+        inst->voice_time_left[i] = flicks < 1 ? 1 : flicks;
+        inst->voice_clock_left[i] = 0;
+    }
+}
+
+static void clock_gates_to_clocks(eucalypso_instance_t *inst) {
+    int i;
+    double interval;
+    if (!inst) return;
+    interval = inst->clock_interval_f > 0.0 ? inst->clock_interval_f : 1.0;
+    for (i = 0; i < inst->voice_count; i++) {
+        int clocks = (int)((double)inst->voice_time_left[i] / interval + 0.999);
+        inst->voice_clock_left[i] = clocks < 1 ? 1 : clocks;
+        inst->voice_time_left[i] = 0;
+    }
+}
+
+static void clock_watchdog_reset(eucalypso_instance_t *inst) {
+    if (!inst) return;
+    inst->clock_stamp_valid = 0;
+    inst->clock_stamp_flicks = 0;
+    inst->clock_ticks_since_stamp = 0;
+    inst->clock_lost = 0;
+}
+
+/* Timestamp an incoming 0xF8 against the tick() flick clock. Several clocks
+ * can arrive between two ticks, so the interval is measured from the first
+ * clock of one block to the first clock of a later block. */
+static void clock_watchdog_stamp(eucalypso_instance_t *inst) {
+    if (!inst) return;
+    if (inst->clock_lost) {
+        inst->clock_lost = 0;
+        clock_gates_to_clocks(inst);
+        inst->clock_stamp_valid = 0;
+        dlog(inst, "clock watchdog recovered voices=%d", inst->voice_count);
+    }
+    if (!inst->clock_stamp_valid) {
+        inst->clock_stamp_valid = 1;
+        inst->clock_stamp_flicks = inst->flick_clock;
+        inst->clock_ticks_since_stamp = 0;
+        return;
+    }
+    if (inst->flick_clock > inst->clock_stamp_flicks) {
+        double measured = (double)(inst->flick_clock - inst->clock_stamp_flicks) /
+                          (double)(inst->clock_ticks_since_stamp + 1);
+        if (inst->clock_interval_f <= 0.0) inst->clock_interval_f = measured;
+        else inst->clock_interval_f += (measured - inst->clock_interval_f) * 0.125;
+        inst->clock_stamp_flicks = inst->flick_clock;
+        inst->clock_ticks_since_stamp = 0;
+        return;
+    }
+    inst->clock_ticks_since_stamp++;
+}
+
+/* Called once per block in clock sync. When no 0xF8 has arrived for
+ * clock_loss_mult expected intervals, sounding voices are moved onto
+ * wall-time timers so they still end even though the clock has gone away. */
+static int clock_watchdog_check(eucalypso_instance_t *inst, uint64_t elapsed,
+                                uint8_t out_msgs[][3], int out_lens[], int max_out, int *count) {
+    double limit;
+    if (!inst || !count) return 0;
+    if (inst->clock_lost) {
+        return advance_voice_timers_flicks(inst, elapsed, out_msgs, out_lens, max_out, count);
+    }
+    if (!inst->clock_running || !inst->clock_stamp_valid || inst->clock_interval_f <= 0.0) return 0;
+    limit = inst->clock_interval_f * (double)clamp_int(inst->clock_loss_mult, 2, 64);
+    if ((double)(inst->flick_clock - inst->clock_stamp_flicks) <= limit) return 0;
+    inst->clock_lost = 1;
+    clock_gates_to_flicks(inst);
+    dlog(inst, "clock watchdog lost interval=%.1f voices=%d", inst->clock_interval_f, inst->voice_count);
+    return 0;
+}
+
+/*
+ * Channel allocation for stacks of mono synths (chan_mode rr/lru).
+ *
+ * Each channel in chan_lo..chan_hi carries at most one voice. A free
+ * channel is found from the busy bitmask: round robin takes the first free
+ * channel at or after the cursor, least recently used the free channel
+ * released longest ago. With every channel busy, the oldest voice in the
+ * range is stolen and its channel reused. Returns the 0-based channel, or -1
+ * when a steal could not be emitted.
+ */
+static uint32_t chan_range_mask(const eucalypso_instance_t *inst) {
+    int lo = clamp_int(inst->chan_lo, 1, 16) - 1;
+    int hi = clamp_int(inst->chan_hi, 1, 16) - 1;
+    if (lo > hi) {
+        int t = lo;
+        lo = hi;
+        hi = t;
+    }
+    return ((2u << hi) - 1u) & ~((1u << lo) - 1u);
+}
+
+static int alloc_channel(eucalypso_instance_t *inst,
+                         uint8_t out_msgs[][3], int out_lens[], int max_out, int *count) {
+    uint32_t range;
+    uint32_t free;
+    int chan;
+    int i;
+    if (inst->chan_mode == CHAN_ALLOC_OFF) return 0;
+    range = chan_range_mask(inst);
+    free = range & ~inst->chan_busy;
+    if (free && inst->chan_mode == CHAN_ALLOC_LRU) {
+        uint32_t m = free;
+        chan = __builtin_ctz(m);
+        for (m &= m - 1u; m; m &= m - 1u) {
+            int c = __builtin_ctz(m);
+            if (inst->chan_stamp[c] < inst->chan_stamp[chan]) chan = c;
+        }
+        return chan;
+    }
+    if (free) {
+        uint32_t ahead = free & (~0u << (inst->chan_next & 15));
+        chan = __builtin_ctz(ahead ? ahead : free);
+        inst->chan_next = (chan + 1) & 15;
+        return chan;
+    }
+    for (i = 0; i < inst->voice_count; i++) {
+        if (range & (1u << inst->voice_chan[i])) {
+            chan = inst->voice_chan[i];
+            if (!voice_note_off(inst, i, out_msgs, out_lens, max_out, count)) return -1;
+            inst->chan_next = (chan + 1) & 15;
+            return chan;
+        }
+    }
+    return __builtin_ctz(range);
+}
+
+/* out_chan 1-16 pins the note to that channel (a part's channel); 0 leaves
+ * it to the allocator. */
+static int schedule_note(eucalypso_instance_t *inst, int note, int velocity, int gate_pct, int out_chan,
                          uint8_t out_msgs[][3], int out_lens[], int max_out, int *count) {
     int voice_limit;
+    int chan;
     uint8_t out_note;
     if (!inst || !count) return 0;
     out_note = (uint8_t)clamp_int(note, 0, 127);
     velocity = clamp_int(velocity, 1, 127);
-    gate_pct = clamp_int(gate_pct, 0, 1600);
+    gate_pct = clamp_int(gate_pct, 0, MAX_VOICE_GATE_PCT);
     voice_limit = clamp_int(inst->max_voices, 1, MAX_VOICES);
 
-    (void)kill_voice_notes(inst, out_note, out_msgs, out_lens, max_out, count);
+    (void)kill_voice_notes(inst, out_note, out_chan > 0 ? out_chan - 1 : -1, out_msgs, out_lens, max_out, count);
     while (inst->voice_count >= voice_limit) {
         if (!voice_note_off(inst, 0, out_msgs, out_lens, max_out, count)) return 0;
     }
-    if (!emit3(out_msgs, out_lens, max_out, count, 0x90, out_note, (uint8_t)velocity)) return 0;
+    chan = out_chan > 0 ? out_chan - 1 : alloc_channel(inst, out_msgs, out_lens, max_out, count);
+    if (chan < 0) return 0;
+    if (!emit3(out_msgs, out_lens, max_out, count, (uint8_t)(0x90 | chan), out_note, (uint8_t)velocity)) return 0;
     if (gate_pct <= 0) {
-        return emit3(out_msgs, out_lens, max_out, count, 0x80, out_note, 0);
+        inst->chan_stamp[chan] = ++inst->chan_clock;
+        return emit3(out_msgs, out_lens, max_out, count, (uint8_t)(0x80 | chan), out_note, 0);
+    }
+    voice_add(inst, out_note, (uint8_t)chan, gate_pct);
+    return 1;
+}
+
+/*
+ * Early emission (latency compensation).
+ *
+ * In internal sync each lane may be played early_ms (global + lane) ahead of
+ * the grid so it reaches the speaker on time through a slow downstream
+ * chain. The step scheduler runs ahead by the largest lane lead; lanes with
+ * a smaller lead hold their notes here until their own emission time. Gates
+ * start when a note is emitted, so note-offs move with it.
+ */
+static double lane_early_flicks(const eucalypso_instance_t *inst, const lane_t *lane) {
+    int ms = clamp_int(inst->early_ms + lane->early_ms, 0, 2 * MAX_EARLY_MS);
+    return ((double)ms * (double)FLICKS_PER_SECOND) / 1000.0;
+}
+
+static void update_early_lead(eucalypso_instance_t *inst) {
+    int p;
+    int i;
+    inst->early_lead_flicks = 0.0;
+    if (inst->sync_mode != SYNC_INTERNAL) return;
+    for (p = 0; p < inst->part_count; p++) {
+        for (i = 0; i < MAX_LANES; i++) {
+            double lead = lane_early_flicks(inst, &inst->parts[p].lanes[i]);
+            if (lead > inst->early_lead_flicks) inst->early_lead_flicks = lead;
+        }
+    }
+}
+
+/*
+ * Swing in clock sync. Internal sync swings by stretching alternate step
+ * intervals; clocked steps fire on clock boundaries, so odd steps are
+ * instead held in the pending queue until swing / 200 of a step after their
+ * boundary, measured from the smoothed clock interval.
+ */
+static double clock_swing_flicks(const eucalypso_instance_t *inst, uint64_t step_id) {
+    double delta;
+    double since;
+    if (inst->sync_mode != SYNC_CLOCK || (step_id & 1u) == 0) return 0.0;
+    if (inst->swing <= 0 || inst->clock_interval_f <= 0.0 || !inst->clock_stamp_valid) return 0.0;
+    delta = (double)inst->clocks_per_step * inst->clock_interval_f * (double)clamp_int(inst->swing, 0, 100) / 200.0;
+    since = (double)(inst->flick_clock - inst->clock_stamp_flicks) +
+            (double)inst->clock_counter * inst->clock_interval_f;
+    return delta > since ? delta - since : 0.0;
+}
+
+/* Queues a note delay flicks from now; plays it at once when the queue is
+ * full. */
+static int defer_note(eucalypso_instance_t *inst, uint64_t delay, int note, int velocity, int gate_pct,
+                      int out_chan, uint8_t out_msgs[][3], int out_lens[], int max_out, int *count) {
+    int idx = inst->pending_count;
+    if (idx >= MAX_PENDING_NOTES) {
+        return schedule_note(inst, note, velocity, gate_pct, out_chan, out_msgs, out_lens, max_out, count);
     }
-    voice_add(inst, out_note, gate_pct);
+    inst->pending_at[idx] = inst->flick_clock + delay;
+    inst->pending_note[idx] = (uint8_t)clamp_int(note, 0, 127);
+    inst->pending_velocity[idx] = (uint8_t)clamp_int(velocity, 1, 127);
+    inst->pending_gate[idx] = gate_pct;
+    inst->pending_chan[idx] = (uint8_t)clamp_int(out_chan, 0, 16);
+    inst->pending_count++;
     return 1;
 }
 
+static int emit_pending_notes(eucalypso_instance_t *inst,
+                              uint8_t out_msgs[][3], int out_lens[], int max_out, int *count) {
+    int i = 0;
+    int emitted = 0;
+    while (i < inst->pending_count && *count < max_out) {
+        if (inst->pending_at[i] > inst->flick_clock) {
+            i++;
+            continue;
+        }
+        if (!schedule_note(inst, inst->pending_note[i], inst->pending_velocity[i], inst->pending_gate[i],
+                           inst->pending_chan[i], out_msgs, out_lens, max_out, count)) {
+            break;
+        }
+        emitted++;
+        inst->pending_count--;
+        memmove(&inst->pending_at[i], &inst->pending_at[i + 1],
+                sizeof(inst->pending_at[0]) * (size_t)(inst->pending_count - i));
+        memmove(&inst->pending_note[i], &inst->pending_note[i + 1], (size_t)(inst->pending_count - i));
+        memmove(&inst->pending_velocity[i], &inst->pending_velocity[i + 1], (size_t)(inst->pending_count - i));
+        memmove(&inst->pending_gate[i], &inst->pending_gate[i + 1],
+                sizeof(inst->pending_gate[0]) * (size_t)(inst->pending_count - i));
+        memmove(&inst->pending_chan[i], &inst->pending_chan[i + 1], (size_t)(inst->pending_count - i));
+    }
+    return emitted;
+}
+
+static void clear_pending_notes(eucalypso_instance_t *inst) {
+    inst->pending_count = 0;
+}
+
 static int euclidean_trigger(uint64_t anchor_step, int steps, int pulses, int rotation) {
     int pos;
     if (steps <= 0) return 0;
@@ -1061,87 +1800,990 @@ static int euclidean_trigger(uint64_t anchor_step, int steps, int pulses, int ro
     return ((pos * pulses) % steps) < pulses;
 }
 
-static int lane_velocity(const eucalypso_instance_t *inst, const lane_t *lane,
-                         int lane_idx, uint64_t rhythm_step) {
-    int velocity;
-    if (!inst || !lane) return 100;
-    velocity = lane->velocity > 0 ? lane->velocity : inst->global_velocity;
-    velocity = clamp_int(velocity, 1, 127);
-    if (inst->global_v_rnd > 0) {
-        uint64_t cycle_step = rand_cycle_step(inst, rhythm_step);
-        uint32_t r = step_rand_u32(global_lane_seed(inst, lane_idx, 0x4000u), cycle_step, 0x4000u);
-        velocity += rand_offset_signed(r, inst->global_v_rnd);
-    }
-    return clamp_int(velocity, 1, 127);
+/*
+ * Tap-to-pattern.
+ *
+ * g_euclid_masks[n][k] holds the rotation-0 mask of euclidean_trigger() for
+ * n steps and k pulses, so each n is already bucketed by popcount. A tapped
+ * phrase is fitted by trying rotations of the buckets nearest the tap count
+ * first; |k - taps| is a lower bound on the Hamming distance, which ends the
+ * scan of an n as soon as no remaining bucket can beat the best match.
+ */
+static uint64_t g_euclid_masks[TAP_MAX_STEPS + 1][TAP_MAX_STEPS + 1];
+static int g_euclid_masks_ready;
+
+static int popcount64(uint64_t v) {
+    return __builtin_popcountll(v);
 }
 
-static int lane_gate(const eucalypso_instance_t *inst, const lane_t *lane,
-                     int lane_idx, uint64_t rhythm_step) {
-    int gate;
-    if (!inst || !lane) return 100;
-    gate = lane->gate > 0 ? lane->gate : inst->global_gate;
-    gate = clamp_int(gate, 0, 1600);
-    if (inst->global_g_rnd > 0) {
-        uint64_t cycle_step = rand_cycle_step(inst, rhythm_step);
-        uint32_t r = step_rand_u32(global_lane_seed(inst, lane_idx, 0x5000u), cycle_step, 0x5000u);
-        gate += rand_offset_signed(r, inst->global_g_rnd);
+static uint64_t steps_mask(int n) {
+    return n >= 64 ? ~(uint64_t)0 : (((uint64_t)1 << n) - 1u);
+}
+
+static void build_euclid_masks(void) {
+    int n;
+    int k;
+    int pos;
+    if (g_euclid_masks_ready) return;
+    for (n = 1; n <= TAP_MAX_STEPS; n++) {
+        for (k = 0; k <= n; k++) {
+            uint64_t mask = 0;
+            for (pos = 0; pos < n; pos++) {
+                if (euclidean_trigger((uint64_t)pos, n, k, 0)) mask |= (uint64_t)1 << pos;
+            }
+            g_euclid_masks[n][k] = mask;
+        }
     }
-    return clamp_int(gate, 0, 1600);
+    g_euclid_masks_ready = 1;
 }
 
-static int lane_should_drop(const eucalypso_instance_t *inst, const lane_t *lane,
-                            int lane_idx, uint64_t rhythm_step) {
-    uint32_t r;
-    if (!inst || !lane) return 0;
-    if (lane->drop <= 0) return 0;
-    r = step_rand_u32((uint32_t)(lane->drop_seed + 1), rand_cycle_step(inst, rhythm_step),
-                      0x1000u + (uint32_t)lane_idx);
-    return chance_hit(r, lane->drop);
+/* Bit pos of the result is bit (pos + rotation) % n of mask, matching the
+ * rotation applied by euclidean_trigger(). */
+static uint64_t rotate_steps_mask(uint64_t mask, int n, int rotation) {
+    if (rotation <= 0) return mask;
+    if (n == 64) return (mask >> rotation) | (mask << (64 - rotation));
+    return ((mask >> rotation) | (mask << (n - rotation))) & steps_mask(n);
 }
 
-static int emit_anchor_step(eucalypso_instance_t *inst, uint64_t step_id,
-                            uint8_t out_msgs[][3], int out_lens[], int max_out) {
-    int count = 0;
-    int lane_idx;
-    uint64_t rhythm_step;
-    if (!inst || max_out < 1) return 0;
+static void tap_reset(eucalypso_instance_t *inst) {
+    if (!inst) return;
+    inst->tap_count = 0;
+    inst->tap_first_step = 0;
+    inst->tap_mask = 0;
+    inst->tap_last_rel = 0;
+}
 
-    if (inst->active_count <= 0) {
-        dlog(inst, "emit_anchor_step skip step=%llu reason=no_active_notes", (unsigned long long)step_id);
-        return 0;
+/* Finds the steps/pulses/rotation whose pattern is nearest the tapped mask.
+ * Ties go to the shortest pattern, then to the pulse count nearest the taps. */
+static void tap_fit(eucalypso_instance_t *inst) {
+    int taps = popcount64(inst->tap_mask);
+    int best = TAP_MAX_STEPS + 1;
+    int n;
+    if (!g_euclid_masks_ready) build_euclid_masks();
+    for (n = inst->tap_last_rel + 1; n <= TAP_MAX_STEPS && best > 0; n++) {
+        int d;
+        for (d = 0; d < best; d++) {
+            int side;
+            for (side = 0; side < (d == 0 ? 1 : 2); side++) {
+                int k = side == 0 ? taps - d : taps + d;
+                int r;
+                if (k < 1 || k > n) continue;
+                for (r = 0; r < n; r++) {
+                    int dist = popcount64(rotate_steps_mask(g_euclid_masks[n][k], n, r) ^ inst->tap_mask);
+                    if (dist < best) {
+                        best = dist;
+                        inst->tap_fit_steps = n;
+                        inst->tap_fit_pulses = k;
+                        inst->tap_fit_rotation = r;
+                    }
+                }
+            }
+        }
     }
-    rhythm_step = rhythm_step_id(inst, step_id);
-    dlog(inst, "emit_anchor_step start step=%llu rhythm_step=%llu active=%d pending=%d",
-         (unsigned long long)step_id, (unsigned long long)rhythm_step,
-         inst->active_count, inst->pending_step_triggers);
-    for (lane_idx = 0; lane_idx < MAX_LANES && count < max_out; lane_idx++) {
-        lane_t *lane = &inst->lanes[lane_idx];
+    inst->tap_fit_distance = best;
+    /* The mask starts at the first tap; shift rotation onto the lane's own
+     * rhythm position so the pattern plays where it was tapped. */
+    n = inst->tap_fit_steps;
+    inst->tap_fit_rotation = (int)(((uint64_t)inst->tap_fit_rotation + (uint64_t)n -
+                                    inst->tap_first_step % (uint64_t)n) % (uint64_t)n);
+}
+
+static void tap_finish(eucalypso_instance_t *inst) {
+    lane_t *lane;
+    if (!inst || inst->tap_lane <= 0 || inst->tap_count <= 0) return;
+    tap_fit(inst);
+    lane = &inst->parts[inst->part_edit].lanes[inst->tap_lane - 1];
+    lane->enabled = 1;
+    lane->steps = inst->tap_fit_steps;
+    lane->pulses = inst->tap_fit_pulses;
+    lane->rotation = inst->tap_fit_rotation;
+    dlog(inst, "tap fit lane=%d taps=%d steps=%d pulses=%d rotation=%d distance=%d",
+         inst->tap_lane, inst->tap_count, lane->steps, lane->pulses, lane->rotation, inst->tap_fit_distance);
+    inst->tap_lane = 0;
+    tap_reset(inst);
+}
+
+/* Quantizes a tap to the nearest step of the running grid. */
+static uint64_t tap_grid_step(const eucalypso_instance_t *inst) {
+    int nearer_next;
+    if (inst->anchor_step == 0) return 0;
+    if (inst->sync_mode == SYNC_CLOCK) {
+        nearer_next = inst->clock_counter * 2 >= inst->clocks_per_step;
+    } else if (inst->sync_mode == SYNC_NOTE) {
+        nearer_next = inst->trig_interval_f > 0.0 &&
+                      (double)(inst->flick_clock - inst->trig_stamp_flicks) * 2.0 >= inst->trig_interval_f;
+    } else {
+        nearer_next = inst->flicks_until_step * 2.0 < inst->step_interval_flicks;
+    }
+    return nearer_next ? inst->anchor_step : inst->anchor_step - 1;
+}
+
+static void tap_note_on(eucalypso_instance_t *inst) {
+    uint64_t step;
+    uint64_t rel;
+    if (!inst || inst->tap_lane <= 0) return;
+    step = rhythm_step_id(inst, tap_grid_step(inst));
+    if (inst->tap_count == 0 || step < inst->tap_first_step) {
+        tap_reset(inst);
+        inst->tap_first_step = step;
+    }
+    rel = step - inst->tap_first_step;
+    if (rel >= TAP_MAX_STEPS) return;
+    inst->tap_mask |= (uint64_t)1 << rel;
+    if ((int)rel > inst->tap_last_rel) inst->tap_last_rel = (int)rel;
+    inst->tap_count++;
+}
+
+/* Ends the phrase after TAP_END_STEPS silent steps or when it fills the
+ * longest pattern. */
+static void tap_poll(eucalypso_instance_t *inst, uint64_t step_id) {
+    uint64_t step;
+    if (!inst || inst->tap_lane <= 0 || inst->tap_count <= 0) return;
+    step = rhythm_step_id(inst, step_id);
+    if (step < inst->tap_first_step) return;
+    if (step - inst->tap_first_step >= (uint64_t)inst->tap_last_rel + TAP_END_STEPS ||
+        step - inst->tap_first_step >= TAP_MAX_STEPS) {
+        tap_finish(inst);
+    }
+}
+
+static int lane_velocity(const eucalypso_instance_t *inst, const lane_t *lane, const step_rand_t *rw) {
+    int velocity;
+    if (!inst || !lane) return 100;
+    velocity = lane->velocity > 0 ? lane->velocity : inst->global_velocity;
+    velocity = clamp_int(velocity, 1, 127);
+    if (inst->global_v_rnd > 0) velocity += rand_offset_signed(rw->w[RAND_VELOCITY], inst->global_v_rnd);
+    return clamp_int(velocity, 1, 127);
+}
+
+static int lane_gate(const eucalypso_instance_t *inst, const lane_t *lane, const step_rand_t *rw) {
+    int gate;
+    if (!inst || !lane) return 100;
+    gate = lane->gate > 0 ? lane->gate : inst->global_gate;
+    gate = clamp_int(gate, 0, 1600);
+    if (inst->global_g_rnd > 0) gate += rand_offset_signed(rw->w[RAND_GATE], inst->global_g_rnd);
+    return clamp_int(gate, 0, 1600);
+}
+
+static int lane_should_drop(const lane_t *lane, const step_rand_t *rw) {
+    if (!lane || lane->drop <= 0) return 0;
+    return chance_hit(rw->w[RAND_DROP], lane->drop);
+}
+
+/*
+ * Evolve mode.
+ *
+ * Each cycle boundary may draw a small step for a lane: pulses +-1, rotation
+ * +-1, drop +-10 and new note/octave seeds. evolve is the chance (0-100) that
+ * a cycle draws one; the step for cycle c comes from (evolve_seed, part,
+ * lane, c). The lane plays with the sum of the steps drawn in its last
+ * EVOLVE_WINDOW_CYCLES cycles, pulses kept within +-EVOLVE_PULSE_SPAN and
+ * drop within +-EVOLVE_DROP_SPAN of the stored lane. Neighbouring steps
+ * build on each other and each one fades out after the window, so the
+ * pattern drifts away from the stored lane and back rather than jumping.
+ * Any cycle is a fixed amount of work from the cycle number alone, so
+ * seeking or a runtime_state import costs the same as playing through.
+ */
+static int evolve_step_at(const eucalypso_instance_t *inst, int part_idx, int lane_idx, uint64_t cycle,
+                          evolve_walk_t *w) {
+    uint32_t r = step_rand_u32((uint32_t)(inst->evolve_seed + 1), cycle,
+                               0x4000u + (uint32_t)(part_idx * MAX_LANES + lane_idx));
+    if (!chance_hit(r, inst->evolve)) return 0;
+    r = mix_u32(r);
+    w->pulses += rand_offset_signed(r, 1);
+    r = mix_u32(r);
+    w->rotation += rand_offset_signed(r, 1);
+    r = mix_u32(r);
+    w->drop += rand_offset_signed(r, 10);
+    return 1;
+}
+
+static void evolve_walk_at(const eucalypso_instance_t *inst, int part_idx, int lane_idx, uint64_t cycle,
+                           evolve_walk_t *w) {
+    uint64_t c = cycle >= EVOLVE_WINDOW_CYCLES ? cycle - EVOLVE_WINDOW_CYCLES + 1 : 1;
+    memset(w, 0, sizeof(*w));
+    for (; c <= cycle && cycle > 0; c++) {
+        if (evolve_step_at(inst, part_idx, lane_idx, c, w)) w->seed_cycle = c;
+    }
+    w->pulses = clamp_int(w->pulses, -EVOLVE_PULSE_SPAN, EVOLVE_PULSE_SPAN);
+    w->drop = clamp_int(w->drop, -EVOLVE_DROP_SPAN, EVOLVE_DROP_SPAN);
+}
+
+static void evolve_apply(const lane_t *base, const evolve_walk_t *w, lane_t *out) {
+    int steps = clamp_int(base->steps, 1, 128);
+    *out = *base;
+    out->pulses = clamp_int(base->pulses + w->pulses, 0, steps);
+    out->rotation = (int)((((int64_t)base->rotation + w->rotation) % steps + steps) % steps);
+    out->drop = clamp_int(base->drop + w->drop, 0, 100);
+    out->n_seed = (int)(((uint64_t)base->n_seed + w->seed_cycle) & 0xFFFFu);
+    out->oct_seed = (int)(((uint64_t)base->oct_seed + w->seed_cycle) & 0xFFFFu);
+}
+
+/* Returns the lane as it plays on rhythm_step, re-deriving it only when the
+ * cycle or the stored lane changes. */
+static const lane_t *evolved_lane(const eucalypso_instance_t *inst, part_t *part, int lane_idx,
+                                  uint64_t rhythm_step) {
+    const lane_t *base = &part->lanes[lane_idx];
+    uint64_t cycle;
+    evolve_walk_t w;
+    if (inst->evolve <= 0) return base;
+    cycle = rhythm_step / (uint64_t)clamp_int(base->steps, 1, 128);
+    if (!part->evolve_valid[lane_idx] || part->evolve_cycle[lane_idx] != cycle ||
+        memcmp(&part->evolve_base[lane_idx], base, sizeof(*base)) != 0) {
+        evolve_walk_at(inst, (int)(part - inst->parts), lane_idx, cycle, &w);
+        evolve_apply(base, &w, &part->evolve_lane[lane_idx]);
+        part->evolve_base[lane_idx] = *base;
+        part->evolve_cycle[lane_idx] = cycle;
+        part->evolve_valid[lane_idx] = 1;
+    }
+    return &part->evolve_lane[lane_idx];
+}
+
+static void evolve_invalidate(eucalypso_instance_t *inst) {
+    int p;
+    for (p = 0; p < MAX_PARTS; p++) memset(inst->parts[p].evolve_valid, 0, sizeof(inst->parts[p].evolve_valid));
+}
+
+/*
+ * Lane direction maps rhythm_step to the step the lane reads, keeping the
+ * cycle and replacing only the position within it. The result feeds both
+ * the pattern lookup and the rand_cycle index, so a reversed lane also
+ * plays its random values backwards. Every direction is a pure function of
+ * rhythm_step, so seeking lands on the same position as playing through.
+ * Ping-pong repeats neither end: 0 1 2 3 2 1 0 1 ...
+ */
+static uint64_t lane_step_at(const lane_t *lane, int lane_idx, uint64_t rhythm_step) {
+    uint64_t n = (uint64_t)clamp_int(lane->steps, 1, 128);
+    uint64_t base = rhythm_step - rhythm_step % n;
+    uint64_t pos = rhythm_step % n;
+    switch (lane->direction) {
+        case DIR_REVERSE:
+            pos = n - 1 - pos;
+            break;
+        case DIR_PINGPONG:
+            if (n > 1) {
+                uint64_t p = rhythm_step % (2 * n - 2);
+                pos = p < n ? p : 2 * n - 2 - p;
+            }
+            break;
+        case DIR_RANDOM:
+            pos = step_rand_u32((uint32_t)(lane->dir_seed + 1), rhythm_step, 0x7000u + (uint32_t)lane_idx) % n;
+            break;
+        case DIR_FORWARD:
+        default:
+            break;
+    }
+    return base + pos;
+}
+
+/*
+ * Legato gates (laneX_legato=on) last until the lane's next hit, scaled by
+ * the gate percentage. Each lane caches its hits in play order over one
+ * direction period (n steps, or 2n - 2 for ping-pong), rebuilt only when the
+ * pattern or direction changes, so the distance to the next hit is a
+ * find-next-set-bit query. Random direction has no period; its next hit is
+ * found by stepping forward, at most one cycle.
+ */
+static int legato_period_for(const lane_t *lane) {
+    int n = clamp_int(lane->steps, 1, 128);
+    if (lane->direction == DIR_PINGPONG && n > 1) return 2 * n - 2;
+    return n;
+}
+
+static int lane_hit_at(const lane_t *lane, int lane_idx, uint64_t rhythm_step) {
+    return euclidean_trigger(lane_step_at(lane, lane_idx, rhythm_step), clamp_int(lane->steps, 1, 128),
+                             clamp_int(lane->pulses, 0, 128), lane->rotation);
+}
+
+static int legato_key_matches(const lane_t *a, const lane_t *b) {
+    return a->steps == b->steps && a->pulses == b->pulses && a->rotation == b->rotation &&
+           a->direction == b->direction;
+}
+
+static void build_legato_mask(part_t *part, const lane_t *lane, int lane_idx) {
+    int period = legato_period_for(lane);
+    int pos;
+    memset(part->legato_mask[lane_idx], 0, sizeof(part->legato_mask[lane_idx]));
+    for (pos = 0; pos < period; pos++) {
+        if (lane_hit_at(lane, lane_idx, (uint64_t)pos)) {
+            part->legato_mask[lane_idx][pos >> 6] |= (uint64_t)1 << (pos & 63);
+        }
+    }
+    part->legato_period[lane_idx] = period;
+    part->legato_key[lane_idx] = *lane;
+    part->legato_valid[lane_idx] = 1;
+}
+
+/* First set bit at or after from, or -1. */
+static int legato_next_bit(const uint64_t *mask, int from, int period) {
+    int word;
+    uint64_t bits;
+    if (from >= period) return -1;
+    word = from >> 6;
+    bits = mask[word] & (~(uint64_t)0 << (from & 63));
+    for (;;) {
+        if (bits) {
+            int bit = (word << 6) + __builtin_ctzll(bits);
+            return bit < period ? bit : -1;
+        }
+        if (++word >= LEGATO_MASK_WORDS || (word << 6) >= period) return -1;
+        bits = mask[word];
+    }
+}
+
+/* Steps from rhythm_step to the lane's next hit (1 when it hits next step). */
+static int legato_distance(part_t *part, const lane_t *lane, int lane_idx, uint64_t rhythm_step) {
+    int period;
+    int phase;
+    int next;
+    if (lane->direction == DIR_RANDOM) {
+        int n = clamp_int(lane->steps, 1, 128);
+        int d;
+        for (d = 1; d <= n; d++) {
+            if (lane_hit_at(lane, lane_idx, rhythm_step + (uint64_t)d)) return d;
+        }
+        return n;
+    }
+    if (!part->legato_valid[lane_idx] || !legato_key_matches(&part->legato_key[lane_idx], lane)) {
+        build_legato_mask(part, lane, lane_idx);
+    }
+    period = part->legato_period[lane_idx];
+    phase = (int)(rhythm_step % (uint64_t)period);
+    next = legato_next_bit(part->legato_mask[lane_idx], phase + 1, period);
+    if (next >= 0) return next - phase;
+    next = legato_next_bit(part->legato_mask[lane_idx], 0, period);
+    return next >= 0 ? next + period - phase : period;
+}
+
+static void emit_part_step(eucalypso_instance_t *inst, int part_idx, uint64_t step_id, uint64_t rhythm_step,
+                           double swing_delay, uint8_t out_msgs[][3], int out_lens[], int max_out, int *count) {
+    part_t *part = &inst->parts[part_idx];
+    int lane_idx;
+    for (lane_idx = 0; lane_idx < MAX_LANES && *count < max_out; lane_idx++) {
+        const lane_t *lane;
+        uint64_t lane_step;
+        step_rand_t rw;
         int note;
-        if (!lane->enabled) continue;
-        if (!lane_gate_enabled_for_step(inst, lane_idx)) continue;
-        if (!euclidean_trigger(rhythm_step, clamp_int(lane->steps, 1, 128),
+        int velocity;
+        int gate;
+        double defer;
+        if (!part->lanes[lane_idx].enabled) continue;
+        lane = evolved_lane(inst, part, lane_idx, rhythm_step);
+        if (!lane_gate_enabled_for_step(inst, part, lane_idx)) continue;
+        lane_step = lane_step_at(lane, lane_idx, rhythm_step);
+        if (!euclidean_trigger(lane_step, clamp_int(lane->steps, 1, 128),
                                clamp_int(lane->pulses, 0, 128),
                                lane->rotation)) {
             continue;
         }
-        if (lane_should_drop(inst, lane, lane_idx, rhythm_step)) {
-            dlog(inst, "emit_anchor_step lane=%d dropped step=%llu rhythm_step=%llu",
-                 lane_idx + 1, (unsigned long long)step_id, (unsigned long long)rhythm_step);
+        lane_step_rand(inst, part, lane, lane_idx, lane_step, &rw);
+        if (lane_should_drop(lane, &rw)) {
+            dlog(inst, "emit_anchor_step part=%d lane=%d dropped step=%llu rhythm_step=%llu",
+                 part_idx + 1, lane_idx + 1, (unsigned long long)step_id, (unsigned long long)rhythm_step);
             continue;
         }
-        note = select_lane_note(inst, lane, lane_idx, rhythm_step);
+        note = select_lane_note(inst, part, lane, &rw);
         if (note < 0) continue;
-        dlog(inst, "emit_anchor_step lane=%d note=%d step=%llu rhythm_step=%llu",
-             lane_idx + 1, note, (unsigned long long)step_id, (unsigned long long)rhythm_step);
-        (void)schedule_note(inst, note,
-                            lane_velocity(inst, lane, lane_idx, rhythm_step),
-                            lane_gate(inst, lane, lane_idx, rhythm_step),
-                            out_msgs, out_lens, max_out, &count);
+        dlog(inst, "emit_anchor_step part=%d lane=%d note=%d step=%llu rhythm_step=%llu",
+             part_idx + 1, lane_idx + 1, note, (unsigned long long)step_id, (unsigned long long)rhythm_step);
+        velocity = lane_velocity(inst, lane, &rw);
+        gate = lane_gate(inst, lane, &rw);
+        if (lane->legato) gate *= legato_distance(part, lane, lane_idx, rhythm_step);
+        if (part_idx == 0) {
+            inst->playhead_hit[lane_idx] = 1;
+            inst->playhead_note[lane_idx] = (uint8_t)note;
+            inst->playhead_velocity[lane_idx] = (uint8_t)velocity;
+        }
+        defer = inst->early_lead_flicks - lane_early_flicks(inst, lane) + swing_delay;
+        if (defer >= 1.0) {
+            (void)defer_note(inst, (uint64_t)(defer + 0.5), note, velocity, gate, part->out_chan,
+                             out_msgs, out_lens, max_out, count);
+            continue;
+        }
+        (void)schedule_note(inst, note, velocity, gate, part->out_chan, out_msgs, out_lens, max_out, count);
+    }
+}
+
+/* Every part plays from the same step, register and swing; only lane
+ * evaluation runs per part. */
+static int emit_anchor_step(eucalypso_instance_t *inst, uint64_t step_id,
+                            uint8_t out_msgs[][3], int out_lens[], int max_out) {
+    int count = 0;
+    int part_idx;
+    uint64_t rhythm_step;
+    double swing_delay;
+    if (!inst || max_out < 1) return 0;
+
+    if (inst->active_count <= 0) {
+        dlog(inst, "emit_anchor_step skip step=%llu reason=no_active_notes", (unsigned long long)step_id);
+        return 0;
+    }
+    rhythm_step = rhythm_step_id(inst, step_id);
+    swing_delay = clock_swing_flicks(inst, step_id);
+    dlog(inst, "emit_anchor_step start step=%llu rhythm_step=%llu active=%d pending=%d",
+         (unsigned long long)step_id, (unsigned long long)rhythm_step,
+         inst->active_count, inst->pending_step_triggers);
+    for (part_idx = 0; part_idx < inst->part_count && count < max_out; part_idx++) {
+        emit_part_step(inst, part_idx, step_id, rhythm_step, swing_delay, out_msgs, out_lens, max_out, &count);
     }
     dlog(inst, "emit_anchor_step end step=%llu out=%d", (unsigned long long)step_id, count);
     return count;
 }
 
+static void normalize_lane(lane_t *lane) {
+    if (!lane) return;
+    lane->steps = clamp_int(lane->steps, 1, 128);
+    lane->pulses = clamp_int(lane->pulses, 0, lane->steps);
+}
+
+static void reset_lane(lane_t *lane, int lane_idx) {
+    if (!lane) return;
+    lane->enabled = (lane_idx == 0) ? 1 : 0;
+    lane->steps = 16;
+    lane->pulses = 4;
+    lane->rotation = 0;
+    lane->drop = 0;
+    lane->drop_seed = 0;
+    lane->note = lane_idx + 1;
+    lane->n_rnd = 0;
+    lane->n_seed = 0;
+    lane->octave = 0;
+    lane->oct_rnd = 0;
+    lane->oct_seed = 0;
+    lane->oct_rng = 2;
+    lane->velocity = 0;
+    lane->gate = 0;
+    lane->early_ms = 0;
+    lane->direction = DIR_FORWARD;
+    lane->dir_seed = 0;
+    lane->legato = 0;
+}
+
+/* Part 1 starts on the allocator, later parts on their own channel. */
+static void reset_part(part_t *part, int part_idx) {
+    int i;
+    part->register_mode = REGISTER_HELD;
+    part->held_order = HELD_UP;
+    part->held_order_seed = 0;
+    part->scale_mode = SCALE_MAJOR;
+    part->scale_rng = 8;
+    part->root_note = 0;
+    part->octave = 0;
+    part->missing_note_policy = MISSING_SKIP;
+    part->missing_note_seed = 0;
+    part->out_chan = part_idx == 0 ? 0 : part_idx + 1;
+    for (i = 0; i < MAX_LANES; i++) reset_lane(&part->lanes[i], i);
+    memset(part->evolve_valid, 0, sizeof(part->evolve_valid));
+    memset(part->legato_valid, 0, sizeof(part->legato_valid));
+}
+
+static void set_sync_mode(eucalypso_instance_t *inst, sync_mode_t mode) {
+    if (!inst) return;
+    inst->sync_mode = mode;
+    clock_watchdog_reset(inst);
+    update_early_lead(inst);
+    inst->trig_stamp_valid = 0;
+    if (inst->sync_mode == SYNC_CLOCK) {
+        recalc_clock_timing(inst);
+        realign_clock_phase(inst);
+        inst->clock_running = 1;
+    } else {
+        inst->clock_running = 1;
+        if (inst->sample_rate > 0) {
+            recalc_internal_timing(inst, inst->sample_rate);
+            realign_internal_phase(inst);
+        }
+    }
+}
+
+static void retime_after_rate_change(eucalypso_instance_t *inst) {
+    if (!inst) return;
+    inst->timing_dirty = 1;
+    recalc_clock_timing(inst);
+    if (inst->sync_mode == SYNC_CLOCK) realign_clock_phase(inst);
+    else if (inst->sample_rate > 0) {
+        recalc_internal_timing(inst, inst->sample_rate);
+        realign_internal_phase(inst);
+    }
+}
+
+/*
+ * Preset library.
+ *
+ * A read-only file built by tools/eucalypso_pack_presets, memory-mapped once per
+ * process on first use and shared by every instance:
+ *
+ *   header   24 bytes: magic "EUPL", version u16, fields-per-block u16,
+ *            count u32, index offset u32, blocks offset u32, reserved u32
+ *   index    count x 64 bytes sorted by name: name[32], tags[24],
+ *            block index u32, reserved u32
+ *   blocks   count x fields-per-block little-endian int32 values, in the
+ *            order of k_preset_global_fields then k_preset_lane_fields
+ *            for each lane
+ *
+ * Recall is a binary search on the index plus a copy of one block into the
+ * instance; nothing is parsed and nothing is copied per instance. Libraries
+ * written with fewer fields leave the remaining parameters untouched.
+ * Version 2 added evolve, rng_version and channel allocation to the global
+ * fields and early_ms, direction and legato to each lane; version 1 files
+ * must be repacked.
+ */
+typedef struct {
+    size_t offset;
+    int lo;
+    int hi;
+} preset_field_t;
+
+typedef struct {
+    const uint8_t *base;
+    size_t size;
+    uint32_t count;
+    uint32_t fields;
+    const uint8_t *index;
+    const uint8_t *blocks;
+    char path[512];
+} preset_lib_t;
+
+_Static_assert(sizeof(play_mode_t) == sizeof(int), "enum params are stored as int in preset blocks");
+
+static const preset_field_t k_preset_global_fields[] = {
+    { offsetof(eucalypso_instance_t, play_mode), 0, 1 },
+    { offsetof(eucalypso_instance_t, retrigger_mode), 0, 1 },
+    { offsetof(eucalypso_instance_t, rate), 0, 8 },
+    { offsetof(eucalypso_instance_t, sync_mode), 0, 2 },
+    { offsetof(eucalypso_instance_t, bpm), 40, 240 },
+    { offsetof(eucalypso_instance_t, swing), 0, 100 },
+    { offsetof(eucalypso_instance_t, max_voices), 1, MAX_VOICES },
+    { offsetof(eucalypso_instance_t, global_velocity), 1, 127 },
+    { offsetof(eucalypso_instance_t, global_v_rnd), 0, 127 },
+    { offsetof(eucalypso_instance_t, global_gate), 1, 1600 },
+    { offsetof(eucalypso_instance_t, global_g_rnd), 0, 1600 },
+    { offsetof(eucalypso_instance_t, global_rnd_seed), 0, 65535 },
+    { offsetof(eucalypso_instance_t, rand_cycle), 1, 128 },
+    { offsetof(eucalypso_instance_t, parts[0].register_mode), 0, 2 },
+    { offsetof(eucalypso_instance_t, parts[0].held_order), 0, 3 },
+    { offsetof(eucalypso_instance_t, parts[0].held_order_seed), 0, 65535 },
+    { offsetof(eucalypso_instance_t, parts[0].missing_note_policy), 0, 3 },
+    { offsetof(eucalypso_instance_t, parts[0].missing_note_seed), 0, 65535 },
+    { offsetof(eucalypso_instance_t, parts[0].scale_mode), 0, 13 },
+    { offsetof(eucalypso_instance_t, parts[0].scale_rng), 1, 24 },
+    { offsetof(eucalypso_instance_t, parts[0].root_note), 0, 11 },
+    { offsetof(eucalypso_instance_t, parts[0].octave), -3, 3 },
+    { offsetof(eucalypso_instance_t, evolve), 0, 100 },
+    { offsetof(eucalypso_instance_t, evolve_seed), 0, 65535 },
+    { offsetof(eucalypso_instance_t, rng_version), 1, 2 },
+    { offsetof(eucalypso_instance_t, chan_mode), 0, 2 },
+    { offsetof(eucalypso_instance_t, chan_lo), 1, 16 },
+    { offsetof(eucalypso_instance_t, chan_hi), 1, 16 }
+};
+
+static const preset_field_t k_preset_lane_fields[] = {
+    { offsetof(lane_t, enabled), 0, 1 },
+    { offsetof(lane_t, steps), 1, 128 },
+    { offsetof(lane_t, pulses), 0, 128 },
+    { offsetof(lane_t, rotation), 0, 127 },
+    { offsetof(lane_t, drop), 0, 100 },
+    { offsetof(lane_t, drop_seed), 0, 65535 },
+    { offsetof(lane_t, note), 1, 24 },
+    { offsetof(lane_t, n_rnd), 0, 100 },
+    { offsetof(lane_t, n_seed), 0, 65535 },
+    { offsetof(lane_t, octave), -3, 3 },
+    { offsetof(lane_t, oct_rnd), 0, 100 },
+    { offsetof(lane_t, oct_seed), 0, 65535 },
+    { offsetof(lane_t, oct_rng), 0, 5 },
+    { offsetof(lane_t, velocity), 0, 127 },
+    { offsetof(lane_t, gate), 0, 1600 },
+    { offsetof(lane_t, early_ms), 0, MAX_EARLY_MS },
+    { offsetof(lane_t, direction), 0, 3 },
+    { offsetof(lane_t, dir_seed), 0, 65535 },
+    { offsetof(lane_t, legato), 0, 1 }
+};
+
+#define PRESET_GLOBAL_FIELD_COUNT ((int)(sizeof(k_preset_global_fields) / sizeof(k_preset_global_fields[0])))
+#define PRESET_LANE_FIELD_COUNT ((int)(sizeof(k_preset_lane_fields) / sizeof(k_preset_lane_fields[0])))
+
+static preset_lib_t g_preset_lib;
+
+static uint32_t read_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void write_le32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t read_le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/* Maps the library at path. A previous mapping is left in place (not
+ * unmapped) so block pointers held by other instances stay valid. */
+static int preset_lib_map(const char *path) {
+    int fd;
+    struct stat st;
+    const uint8_t *base;
+    uint32_t count;
+    uint32_t fields;
+    uint32_t index_off;
+    uint32_t blocks_off;
+    uint32_t i;
+    if (!path || !path[0]) return 0;
+    if (g_preset_lib.base && strcmp(g_preset_lib.path, path) == 0) return 1;
+    fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    if (fstat(fd, &st) != 0 || st.st_size < PRESET_HEADER_SIZE) {
+        close(fd);
+        return 0;
+    }
+    base = (const uint8_t *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == (const uint8_t *)MAP_FAILED) return 0;
+
+    count = read_le32(base + 8);
+    fields = read_le16(base + 6);
+    index_off = read_le32(base + 12);
+    blocks_off = read_le32(base + 16);
+    if (read_le32(base) != PRESET_LIB_MAGIC || read_le16(base + 4) != PRESET_LIB_VERSION ||
+        fields == 0 ||
+        (uint64_t)index_off + (uint64_t)count * PRESET_INDEX_ENTRY_SIZE > (uint64_t)st.st_size ||
+        (uint64_t)blocks_off + (uint64_t)count * fields * 4u > (uint64_t)st.st_size) {
+        munmap((void *)base, (size_t)st.st_size);
+        return 0;
+    }
+    for (i = 0; i < count; i++) {
+        const uint8_t *entry = base + index_off + (size_t)i * PRESET_INDEX_ENTRY_SIZE;
+        if (read_le32(entry + PRESET_NAME_LEN + PRESET_TAGS_LEN) >= count ||
+            memchr(entry, '\0', PRESET_NAME_LEN) == NULL ||
+            memchr(entry + PRESET_NAME_LEN, '\0', PRESET_TAGS_LEN) == NULL) {
+            munmap((void *)base, (size_t)st.st_size);
+            return 0;
+        }
+    }
+
+    g_preset_lib.base = base;
+    g_preset_lib.size = (size_t)st.st_size;
+    g_preset_lib.count = count;
+    g_preset_lib.fields = fields;
+    g_preset_lib.index = base + index_off;
+    g_preset_lib.blocks = base + blocks_off;
+    snprintf(g_preset_lib.path, sizeof(g_preset_lib.path), "%s", path);
+    return 1;
+}
+
+static const preset_lib_t *preset_lib_get(void) {
+    if (!g_preset_lib.base && !g_preset_lib_default_tried && g_preset_lib_default_path[0]) {
+        g_preset_lib_default_tried = 1;
+        (void)preset_lib_map(g_preset_lib_default_path);
+    }
+    return g_preset_lib.base ? &g_preset_lib : NULL;
+}
+
+static const uint8_t *preset_entry(const preset_lib_t *lib, int idx) {
+    if (!lib || idx < 0 || (uint32_t)idx >= lib->count) return NULL;
+    return lib->index + (size_t)idx * PRESET_INDEX_ENTRY_SIZE;
+}
+
+static int preset_find(const preset_lib_t *lib, const char *name) {
+    int lo = 0;
+    int hi;
+    if (!lib || !name) return -1;
+    hi = (int)lib->count - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        int cmp = strncmp(name, (const char *)preset_entry(lib, mid), PRESET_NAME_LEN);
+        if (cmp == 0) return mid;
+        if (cmp < 0) hi = mid - 1;
+        else lo = mid + 1;
+    }
+    return -1;
+}
+
+static const uint8_t *preset_block(const preset_lib_t *lib, int idx) {
+    const uint8_t *entry = preset_entry(lib, idx);
+    if (!entry) return NULL;
+    return lib->blocks + (size_t)read_le32(entry + PRESET_NAME_LEN + PRESET_TAGS_LEN) * lib->fields * 4u;
+}
+
+static void preset_store_field(void *base, const preset_field_t *field, const uint8_t *raw) {
+    int v = clamp_int((int)(int32_t)read_le32(raw), field->lo, field->hi);
+    memcpy((char *)base + field->offset, &v, sizeof(v));
+}
+
+static void copy_param_block(eucalypso_instance_t *inst, const uint8_t *block, int fields) {
+    int f = 0;
+    int i;
+    int l;
+    for (i = 0; i < PRESET_GLOBAL_FIELD_COUNT && f < fields; i++, f++) {
+        preset_store_field(inst, &k_preset_global_fields[i], block + f * 4);
+    }
+    for (l = 0; l < MAX_LANES; l++) {
+        for (i = 0; i < PRESET_LANE_FIELD_COUNT && f < fields; i++, f++) {
+            preset_store_field(&inst->parts[0].lanes[l], &k_preset_lane_fields[i], block + f * 4);
+        }
+        normalize_lane(&inst->parts[0].lanes[l]);
+    }
+    evolve_invalidate(inst);
+}
+
+static void apply_param_block(eucalypso_instance_t *inst, const uint8_t *block, int fields) {
+    play_mode_t play_mode;
+    sync_mode_t sync_mode;
+    rate_t rate;
+    int bpm;
+    if (!inst || !block) return;
+    play_mode = inst->play_mode;
+    sync_mode = inst->sync_mode;
+    rate = inst->rate;
+    bpm = inst->bpm;
+    copy_param_block(inst, block, fields);
+
+    if (inst->play_mode != play_mode) {
+        play_mode_t next = inst->play_mode;
+        inst->play_mode = play_mode;
+        set_play_mode(inst, next);
+    }
+    if (inst->bpm != bpm) inst->ramp_active = 0;
+    if (inst->sync_mode != sync_mode) set_sync_mode(inst, inst->sync_mode);
+    else if (inst->rate != rate || (inst->bpm != bpm && inst->sync_mode == SYNC_INTERNAL)) retime_after_rate_change(inst);
+}
+
+/*
+ * Song mode.
+ *
+ * The song is a list of (preset slot, bars, repeat) entries walked on the
+ * audio thread. Library blocks are resolved to pointers when the list is
+ * set, so a section change on the step that starts its bar is a block copy
+ * with no lookup or parsing. set_param builds a new list aside and swaps it
+ * in with one pointer store; the audio thread rewinds when it sees it, so a
+ * step never mixes two lists. Play mode and sync source belong to the
+ * performance, not the section, and are kept; a rate or tempo change
+ * retimes from the boundary step onward. The list loops at its end.
+ */
+static int song_steps_per_bar(const eucalypso_instance_t *inst) {
+    int steps = (int)(4.0 * rate_notes_per_beat(inst->rate) + 0.5);
+    return steps < 1 ? 1 : steps;
+}
+
+static void song_rewind(eucalypso_instance_t *inst) {
+    if (!inst) return;
+    inst->song_entry = -1;
+    inst->song_repeat_left = 0;
+    inst->song_steps_left = 0;
+    inst->song_retimed = 0;
+}
+
+static void song_enter_section(eucalypso_instance_t *inst, const song_list_t *list) {
+    const uint8_t *block;
+    play_mode_t play_mode = inst->play_mode;
+    sync_mode_t sync_mode = inst->sync_mode;
+    rate_t rate = inst->rate;
+    int bpm = inst->bpm;
+    if (inst->song_repeat_left > 1) {
+        inst->song_repeat_left--;
+    } else {
+        inst->song_entry = (inst->song_entry + 1) % list->count;
+        inst->song_repeat_left = list->repeat[inst->song_entry];
+    }
+    block = list->block[inst->song_entry];
+    if (block) {
+        copy_param_block(inst, block, list->block_fields);
+        inst->play_mode = play_mode;
+        inst->sync_mode = sync_mode;
+        if (inst->rate != rate || inst->bpm != bpm) {
+            if (inst->bpm != bpm) inst->ramp_active = 0;
+            recalc_clock_timing(inst);
+            recalc_internal_interval(inst);
+            inst->swing_phase = 0;
+            inst->song_retimed = 1;
+        }
+    }
+    inst->song_steps_left = list->bars[inst->song_entry] * song_steps_per_bar(inst);
+    dlog(inst, "song section entry=%d slot=%d repeat_left=%d steps=%d",
+         inst->song_entry, list->slot[inst->song_entry], inst->song_repeat_left, inst->song_steps_left);
+}
+
+/* Audio thread, once per step. A list published since the last step
+ * restarts the song from its first entry on this step. */
+static void song_advance(eucalypso_instance_t *inst) {
+    const song_list_t *list;
+    if (!inst) return;
+    __atomic_store_n(&inst->song_busy, 1, __ATOMIC_SEQ_CST);
+    list = __atomic_load_n(&inst->song_list, __ATOMIC_SEQ_CST);
+    if (list->gen != inst->song_seen_gen) {
+        song_rewind(inst);
+        inst->song_seen_gen = list->gen;
+    }
+    if (inst->song_mode && list->count > 0) {
+        if (inst->song_steps_left <= 0) song_enter_section(inst, list);
+        inst->song_steps_left--;
+    }
+    __atomic_store_n(&inst->song_busy, 0, __ATOMIC_RELEASE);
+}
+
+/* UI thread: the list set_param may fill, i.e. the one not published. */
+static song_list_t *song_staging(eucalypso_instance_t *inst) {
+    const song_list_t *cur = __atomic_load_n(&inst->song_list, __ATOMIC_ACQUIRE);
+    return cur == &inst->song_lists[0] ? &inst->song_lists[1] : &inst->song_lists[0];
+}
+
+/* UI thread: publishes next and returns once the audio thread can no longer
+ * be reading the list it replaced, so that one may be refilled. */
+static void song_publish(eucalypso_instance_t *inst, song_list_t *next) {
+    next->gen = __atomic_load_n(&inst->song_list, __ATOMIC_ACQUIRE)->gen + 1u;
+    (void)__atomic_exchange_n(&inst->song_list, next, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&inst->song_busy, __ATOMIC_SEQ_CST)) sched_yield();
+}
+
+/*
+ * Shared playhead.
+ *
+ * Setting playhead_shm maps a small file of that name under /dev/shm, which
+ * the engine rewrites after every step: transport position and, per lane,
+ * the pattern mask, the position just read, whether it played and the last
+ * note. The UI can poll the mapping at frame rate
+ * without get_param calls. Readers retry while seq is odd or changed across
+ * their copy.
+ *
+ * Remapping happens on the UI thread while the audio thread may be
+ * publishing: the UI thread writes only the new mapping's header, swaps it
+ * in atomically and unmaps the old one once no publish is in flight. Only
+ * the audio thread reads lane and transport state into a mapping; it fills
+ * a new one on its next tick.
+ */
+static void playhead_build_mask(const lane_t *lane, int n, uint64_t mask[2]) {
+    int pulses = clamp_int(lane->pulses, 0, 128);
+    int pos;
+    mask[0] = 0;
+    mask[1] = 0;
+    for (pos = 0; pos < n; pos++) {
+        if (euclidean_trigger((uint64_t)pos, n, pulses, lane->rotation)) {
+            mask[pos >> 6] |= (uint64_t)1 << (pos & 63);
+        }
+    }
+}
+
+/* Audio thread: the lane's mask from the cache, rebuilt when its
+ * steps/pulses/rotation changed. Returns 1 when it was rebuilt. */
+static int playhead_cached_mask(eucalypso_instance_t *inst, const lane_t *lane, int lane_idx, int n) {
+    int *key = inst->playhead_mask_key[lane_idx];
+    if (key[0] == n && key[1] == lane->pulses && key[2] == lane->rotation) return 0;
+    playhead_build_mask(lane, n, inst->playhead_mask[lane_idx]);
+    key[0] = n;
+    key[1] = lane->pulses;
+    key[2] = lane->rotation;
+    return 1;
+}
+
+/* Audio thread: writes one snapshot into ph. Lanes include evolve, and a
+ * mask is only copied when it changed or gen says ph is a new mapping. */
+static void playhead_write(eucalypso_instance_t *inst, playhead_t *ph, uint64_t step_id, uint32_t gen) {
+    uint64_t rhythm_step = rhythm_step_id(inst, step_id);
+    uint32_t seq = ph->seq;
+    int fresh = gen != inst->playhead_written_gen;
+    int i;
+#if defined(__SANITIZE_THREAD__)
+    /* GCC rejects fences under -fsanitize=thread; the acquire side of the
+     * exchange keeps the payload stores after it. */
+    (void)__atomic_exchange_n(&ph->seq, seq + 1u, __ATOMIC_ACQ_REL);
+#else
+    __atomic_store_n(&ph->seq, seq + 1u, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+#endif
+    ph->running = (uint32_t)inst->clock_running;
+    ph->anchor_step = inst->anchor_step;
+    ph->flick_clock = inst->flick_clock;
+    for (i = 0; i < MAX_LANES; i++) {
+        const lane_t *lane = evolved_lane(inst, &inst->parts[0], i, rhythm_step);
+        playhead_lane_t *out = &ph->lanes[i];
+        int n = clamp_int(lane->steps, 1, 128);
+        if (playhead_cached_mask(inst, lane, i, n) || fresh) {
+            out->mask[0] = inst->playhead_mask[i][0];
+            out->mask[1] = inst->playhead_mask[i][1];
+        }
+        out->steps = (uint16_t)n;
+        out->position = (uint16_t)(lane_step_at(lane, i, rhythm_step) % (uint64_t)n);
+        out->enabled = (uint8_t)(inst->parts[0].lanes[i].enabled ? 1 : 0);
+        out->hit = inst->playhead_hit[i];
+        out->last_note = inst->playhead_note[i];
+        out->last_velocity = inst->playhead_velocity[i];
+    }
+    inst->playhead_written_gen = gen;
+    __atomic_store_n(&ph->seq, seq + 2u, __ATOMIC_RELEASE);
+}
+
+/* The generation is read before the mapping: a new mapping seen with the
+ * old generation is still written in full, and published again next tick. */
+static void playhead_publish(eucalypso_instance_t *inst, uint64_t step_id) {
+    playhead_t *ph;
+    uint32_t gen;
+    __atomic_store_n(&inst->playhead_busy, 1, __ATOMIC_SEQ_CST);
+    gen = __atomic_load_n(&inst->playhead_gen, __ATOMIC_SEQ_CST);
+    ph = __atomic_load_n(&inst->playhead, __ATOMIC_SEQ_CST);
+    if (ph) playhead_write(inst, ph, step_id, gen);
+    else inst->playhead_written_gen = gen;
+    __atomic_store_n(&inst->playhead_busy, 0, __ATOMIC_RELEASE);
+}
+
+/* Audio thread, once per tick: fills a mapping installed since the last
+ * publish without waiting for the next step. */
+static void playhead_poll(eucalypso_instance_t *inst) {
+    if (__atomic_load_n(&inst->playhead_gen, __ATOMIC_ACQUIRE) == inst->playhead_written_gen) return;
+    playhead_publish(inst, inst->anchor_step > 0 ? inst->anchor_step - 1 : 0);
+}
+
+/* Installs next (or none) and unmaps the previous mapping once the audio
+ * thread can no longer be writing through it. The generation moves only
+ * after that, so a publish that sees the new generation also sees the new
+ * mapping and copies every mask into it. */
+static void playhead_swap(eucalypso_instance_t *inst, playhead_t *next) {
+    playhead_t *old = __atomic_exchange_n(&inst->playhead, next, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&inst->playhead_busy, __ATOMIC_SEQ_CST)) sched_yield();
+    if (old) munmap(old, sizeof(playhead_t));
+    __atomic_fetch_add(&inst->playhead_gen, 1u, __ATOMIC_RELEASE);
+}
+
+static void playhead_unmap(eucalypso_instance_t *inst) {
+    playhead_swap(inst, NULL);
+    inst->playhead_name[0] = '\0';
+}
+
+static int playhead_map(eucalypso_instance_t *inst, const char *name) {
+    char path[192];
+    struct stat st;
+    playhead_t *ph;
+    void *base;
+    int fd;
+    if (!name || !name[0] || strcmp(name, "off") == 0) {
+        playhead_unmap(inst);
+        return 1;
+    }
+    if (strcmp(name, inst->playhead_name) == 0) return 1;
+    if (strlen(name) >= sizeof(inst->playhead_name)) return 0;
+    if (strchr(name, '/') || strcmp(name, ".") == 0 || strcmp(name, "..") == 0) return 0;
+    snprintf(path, sizeof(path), "/dev/shm/%s", name);
+    fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return 0;
+    if (fstat(fd, &st) != 0 ||
+        (st.st_size < (off_t)sizeof(playhead_t) && ftruncate(fd, (off_t)sizeof(playhead_t)) != 0)) {
+        close(fd);
+        return 0;
+    }
+    base = mmap(NULL, sizeof(playhead_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return 0;
+    ph = (playhead_t *)base;
+    ph->magic = PLAYHEAD_MAGIC;
+    ph->version = PLAYHEAD_VERSION;
+    ph->lane_count = MAX_LANES;
+    if (ph->seq & 1u) ph->seq++;
+    playhead_swap(inst, ph);
+    snprintf(inst->playhead_name, sizeof(inst->playhead_name), "%s", name);
+    return 1;
+}
+
 static int run_anchor_step(eucalypso_instance_t *inst,
                            uint8_t out_msgs[][3], int out_lens[], int max_out) {
     int count;
@@ -1153,15 +2795,79 @@ static int run_anchor_step(eucalypso_instance_t *inst,
         inst->phrase_restart_pending = 0;
         dlog(inst, "phrase restart step=%llu", (unsigned long long)step_id);
     }
+    song_advance(inst);
+    tap_poll(inst, step_id);
+    memset(inst->playhead_hit, 0, sizeof(inst->playhead_hit));
     count = emit_anchor_step(inst, step_id, out_msgs, out_lens, max_out);
     inst->anchor_step++;
+    playhead_publish(inst, step_id);
     return count;
 }
 
+/* Advance the anchor without evaluating lanes, so skipped backlog steps keep
+ * phrase restarts and step numbering identical to a played step. */
+static void skip_anchor_step(eucalypso_instance_t *inst) {
+    if (!inst) return;
+    if (inst->phrase_restart_pending && inst->active_count > 0) {
+        inst->phrase_anchor_step = inst->anchor_step;
+        inst->phrase_restart_pending = 0;
+    }
+    song_advance(inst);
+    tap_poll(inst, inst->anchor_step);
+    inst->backlog_skipped++;
+    dlog(inst, "catchup skip step=%llu", (unsigned long long)inst->anchor_step);
+    memset(inst->playhead_hit, 0, sizeof(inst->playhead_hit));
+    inst->anchor_step++;
+    playhead_publish(inst, inst->anchor_step - 1);
+}
+
+/* age_flicks is measured from the end of the current block, so a step due
+ * anywhere within an ordinary block would look up to one block late.
+ * quantum_flicks (the shorter of this block and the previous one) is the
+ * floor of the skip limit: only a block that runs long, i.e. a stall, can
+ * leave steps older than that. */
+static int catchup_should_play(const eucalypso_instance_t *inst, int is_latest, double age_flicks,
+                               double quantum_flicks) {
+    double limit;
+    if (!inst) return 1;
+    switch (inst->catchup_policy) {
+        case CATCHUP_LATEST:
+            return is_latest;
+        case CATCHUP_SKIP:
+            limit = ((double)inst->catchup_ms * (double)FLICKS_PER_SECOND) / 1000.0;
+            if (limit < quantum_flicks) limit = quantum_flicks;
+            return age_flicks <= limit;
+        case CATCHUP_ALL:
+        default:
+            return 1;
+    }
+}
+
+static void note_backlog_depth(eucalypso_instance_t *inst, int depth) {
+    if (!inst) return;
+    if (depth > inst->backlog_depth_peak) inst->backlog_depth_peak = depth;
+}
+
+static void reset_backlog_stats(eucalypso_instance_t *inst) {
+    if (!inst) return;
+    inst->backlog_depth_peak = 0;
+    inst->backlog_skipped = 0;
+}
+
+static const char *catchup_to_string(catchup_policy_t policy) {
+    switch (policy) {
+        case CATCHUP_LATEST: return "latest";
+        case CATCHUP_SKIP: return "skip";
+        case CATCHUP_ALL:
+        default: return "all";
+    }
+}
+
 static int process_clock_tick(eucalypso_instance_t *inst,
                               uint8_t out_msgs[][3], int out_lens[], int max_out) {
     int count = 0;
     if (!inst || max_out < 1) return 0;
+    clock_watchdog_stamp(inst);
     (void)advance_voice_timers_clock(inst, out_msgs, out_lens, max_out, &count);
     inst->clock_tick_total++;
     if (inst->clocks_per_step < 1) inst->clocks_per_step = 1;
@@ -1176,11 +2882,45 @@ static int process_clock_tick(eucalypso_instance_t *inst,
     return count;
 }
 
+/*
+ * Note-clocked advance (sync=note).
+ *
+ * Each note-on matching trig_note (and trig_chan, 0 = any channel) is one
+ * step: it is evaluated and emitted from process_midi itself, with no wait
+ * for the next tick. Gate lengths follow the measured trigger interval,
+ * falling back to the internal bpm/rate interval until two triggers have
+ * arrived.
+ */
+static int is_trigger_note(const eucalypso_instance_t *inst, const uint8_t *msg) {
+    if (inst->sync_mode != SYNC_NOTE) return 0;
+    if (msg[1] != (uint8_t)inst->trig_note) return 0;
+    return inst->trig_chan == 0 || (msg[0] & 0x0F) == (uint8_t)(inst->trig_chan - 1);
+}
+
+static int process_trigger_note(eucalypso_instance_t *inst,
+                                uint8_t out_msgs[][3], int out_lens[], int max_out) {
+    if (inst->trig_stamp_valid && inst->flick_clock > inst->trig_stamp_flicks) {
+        double measured = (double)(inst->flick_clock - inst->trig_stamp_flicks);
+        if (inst->trig_interval_f <= 0.0) inst->trig_interval_f = measured;
+        else inst->trig_interval_f += (measured - inst->trig_interval_f) * 0.25;
+    }
+    inst->trig_stamp_flicks = inst->flick_clock;
+    inst->trig_stamp_valid = 1;
+    capture_poll(inst);
+    if (inst->trig_interval_f <= 0.0) recalc_internal_interval(inst);
+    return run_anchor_step(inst, out_msgs, out_lens, max_out);
+}
+
 static int handle_transport_stop(eucalypso_instance_t *inst,
                                  uint8_t out_msgs[][3], int out_lens[], int max_out) {
     int count = 0;
     if (!inst) return 0;
     (void)flush_all_voices(inst, out_msgs, out_lens, max_out, &count);
+    if (inst->ramp_active) {
+        inst->ramp_active = 0;
+        inst->timing_dirty = 1;
+    }
+    clear_pending_notes(inst);
     inst->pending_step_triggers = 0;
     inst->clock_counter = 0;
     inst->clock_tick_total = 0;
@@ -1193,17 +2933,21 @@ static int handle_transport_stop(eucalypso_instance_t *inst,
     inst->suppress_initial_note_restart = 0;
     inst->clock_start_grace_armed = 0;
     inst->internal_start_grace_armed = 0;
-    inst->internal_sample_total = 0;
-    inst->samples_until_step_f = inst->step_interval_base_f > 0.0 ? inst->step_interval_base_f : 1.0;
-    inst->samples_until_step = (int)(inst->samples_until_step_f + 0.5);
-    if (inst->samples_until_step < 1) inst->samples_until_step = 1;
+    inst->internal_flicks = 0;
+    inst->flicks_until_step = inst->step_interval_flicks > 0.0 ? inst->step_interval_flicks : 1.0;
     inst->swing_phase = 0;
     inst->clock_running = (inst->sync_mode == SYNC_CLOCK) ? 0 : 1;
     inst->clock_start_grace_armed = 0;
+    clock_watchdog_reset(inst);
+    reset_backlog_stats(inst);
+    song_rewind(inst);
     inst->physical_count = 0;
     inst->physical_as_played_count = 0;
+    inst->capture_count = 0;
     clear_active(inst);
     inst->latch_ready_replace = inst->play_mode == PLAY_LATCH ? 1 : 0;
+    memset(inst->playhead_hit, 0, sizeof(inst->playhead_hit));
+    playhead_publish(inst, 0);
     return count;
 }
 
@@ -1284,45 +3028,28 @@ static void apply_default_state(eucalypso_instance_t *inst) {
     inst->bpm = DEFAULT_BPM;
     inst->swing = 0;
     inst->max_voices = 8;
+    inst->chan_mode = CHAN_ALLOC_OFF;
+    inst->chan_lo = 1;
+    inst->chan_hi = 16;
     inst->global_velocity = 100;
     inst->global_v_rnd = 0;
     inst->global_gate = 100;
     inst->global_g_rnd = 0;
     inst->global_rnd_seed = 0;
     inst->rand_cycle = 16;
-    inst->register_mode = REGISTER_HELD;
-    inst->held_order = HELD_UP;
-    inst->held_order_seed = 0;
-    inst->scale_mode = SCALE_MAJOR;
-    inst->scale_rng = 8;
-    inst->root_note = 0;
-    inst->octave = 0;
-    inst->missing_note_policy = MISSING_SKIP;
-    inst->missing_note_seed = 0;
-    for (i = 0; i < MAX_LANES; i++) {
-        lane_t *lane = &inst->lanes[i];
-        lane->enabled = (i == 0) ? 1 : 0;
-        lane->steps = 16;
-        lane->pulses = 4;
-        lane->rotation = 0;
-        lane->drop = 0;
-        lane->drop_seed = 0;
-        lane->note = i + 1;
-        lane->n_rnd = 0;
-        lane->n_seed = 0;
-        lane->octave = 0;
-        lane->oct_rnd = 0;
-        lane->oct_seed = 0;
-        lane->oct_rng = 2;
-        lane->velocity = 0;
-        lane->gate = 0;
-    }
+    inst->evolve = 0;
+    inst->evolve_seed = 0;
+    inst->rng_version = 1;
+    evolve_invalidate(inst);
+    for (i = 0; i < MAX_PARTS; i++) reset_part(&inst->parts[i], i);
+    inst->part_count = 1;
+    inst->part_edit = 0;
+    inst->song_list = &inst->song_lists[0];
+    song_rewind(inst);
     inst->sample_rate = 0;
     inst->timing_dirty = 1;
-    inst->step_interval_base = 1;
-    inst->samples_until_step = 1;
-    inst->step_interval_base_f = 1.0;
-    inst->samples_until_step_f = 1.0;
+    inst->step_interval_flicks = 1.0;
+    inst->flicks_until_step = 1.0;
     inst->clock_counter = 0;
     inst->clock_running = 1;
     inst->midi_transport_started = 0;
@@ -1330,6 +3057,17 @@ static void apply_default_state(eucalypso_instance_t *inst) {
     inst->clock_start_grace_armed = 0;
     inst->internal_start_grace_armed = 0;
     inst->clocks_per_step = 6;
+    inst->clock_loss_mult = DEFAULT_CLOCK_LOSS_MULT;
+    inst->trig_note = DEFAULT_TRIG_NOTE;
+    inst->trig_chan = 0;
+    inst->trig_stamp_valid = 0;
+    inst->trig_interval_f = 0.0;
+    inst->catchup_policy = CATCHUP_ALL;
+    inst->catchup_ms = DEFAULT_CATCHUP_MS;
+    inst->early_ms = 0;
+    inst->capture_ms = 0;
+    inst->early_lead_flicks = 0.0;
+    clear_pending_notes(inst);
     inst->phrase_anchor_step = 0;
     inst->phrase_restart_pending = 0;
     recalc_clock_timing(inst);
@@ -1342,6 +3080,10 @@ static void *eucalypso_create_instance(const char *module_dir, const char *confi
     if (!inst) return NULL;
     apply_default_state(inst);
     cache_chain_params_from_module_json(inst, module_dir);
+    if (module_dir && module_dir[0] && !g_preset_lib_default_path[0]) {
+        snprintf(g_preset_lib_default_path, sizeof(g_preset_lib_default_path), "%s/%s",
+                 module_dir, PRESET_LIB_FILENAME);
+    }
     dlog(inst, "create sync=%d cps=%d", (int)inst->sync_mode, inst->clocks_per_step);
     return inst;
 }
@@ -1350,6 +3092,7 @@ static void eucalypso_destroy_instance(void *instance) {
     eucalypso_instance_t *inst = (eucalypso_instance_t *)instance;
     if (!inst) return;
     dlog(inst, "destroy");
+    playhead_unmap(inst);
     if (inst->debug_fp) {
         fclose(inst->debug_fp);
         inst->debug_fp = NULL;
@@ -1357,6 +3100,472 @@ static void eucalypso_destroy_instance(void *instance) {
     free(inst);
 }
 
+/*
+ * Live runtime state handoff.
+ *
+ * A replacement instance (module reload/upgrade, chain rebuild) can resume
+ * on the same step: the old instance exports transport position, clock and
+ * internal phase (in flicks), held/active note sets, sounding voices with their
+ * remaining gate and notes still queued for a lane offset or swing as a little-endian binary blob, hex-encoded because
+ * get_param/set_param carry strings. Parameters still travel via "state";
+ * load "state" first, then "runtime_state".
+ */
+typedef struct {
+    uint8_t *buf;
+    int len;
+    int cap;
+    int ok;
+} blob_writer_t;
+
+typedef struct {
+    const uint8_t *buf;
+    int len;
+    int pos;
+    int ok;
+} blob_reader_t;
+
+typedef struct {
+    int sample_rate;
+    uint64_t anchor_step;
+    uint64_t phrase_anchor_step;
+    int phrase_restart_pending;
+    uint64_t clock_tick_total;
+    int pending_step_triggers;
+    int clock_running;
+    int midi_transport_started;
+    uint64_t internal_flicks;
+    double flicks_until_step;
+    int swing_phase;
+    int latch_ready_replace;
+    double clock_interval_f;
+    int clock_stamp_valid;
+    uint64_t clock_stamp_age;
+    int clock_ticks_since_stamp;
+    uint8_t physical_notes[MAX_HELD_NOTES];
+    int physical_count;
+    uint8_t physical_as_played[MAX_HELD_NOTES];
+    int physical_as_played_count;
+    uint8_t active_notes[MAX_HELD_NOTES];
+    int active_count;
+    uint8_t active_as_played[MAX_HELD_NOTES];
+    int active_as_played_count;
+    uint8_t capture_events[MAX_CAPTURE_EVENTS];
+    int capture_count;
+    uint64_t capture_left;
+    uint8_t voice_notes[MAX_VOICES];
+    uint8_t voice_chan[MAX_VOICES];
+    int voice_clock_left[MAX_VOICES];
+    int64_t voice_time_left[MAX_VOICES];
+    int voice_count;
+    uint64_t pending_left[MAX_PENDING_NOTES];
+    uint8_t pending_note[MAX_PENDING_NOTES];
+    uint8_t pending_velocity[MAX_PENDING_NOTES];
+    int pending_gate[MAX_PENDING_NOTES];
+    uint8_t pending_chan[MAX_PENDING_NOTES];
+    int pending_count;
+    int song_entry;
+    int song_repeat_left;
+    int song_steps_left;
+    int ramp_active;
+    double ramp_from_bpm;
+    double ramp_to_bpm;
+    double ramp_length_beats;
+    double ramp_beat;
+} runtime_snapshot_t;
+
+static void blob_put(blob_writer_t *w, uint64_t v, int bytes) {
+    int i;
+    if (!w->ok || w->len + bytes > w->cap) {
+        w->ok = 0;
+        return;
+    }
+    for (i = 0; i < bytes; i++) w->buf[w->len++] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t blob_get(blob_reader_t *r, int bytes) {
+    uint64_t v = 0;
+    int i;
+    if (!r->ok || r->pos + bytes > r->len) {
+        r->ok = 0;
+        return 0;
+    }
+    for (i = 0; i < bytes; i++) v |= (uint64_t)r->buf[r->pos++] << (8 * i);
+    return v;
+}
+
+static void blob_put_notes(blob_writer_t *w, const uint8_t *notes, int count) {
+    int i;
+    blob_put(w, (uint64_t)count, 1);
+    for (i = 0; i < count; i++) blob_put(w, notes[i], 1);
+}
+
+static int blob_get_notes(blob_reader_t *r, uint8_t *notes, int max_count) {
+    int count = (int)blob_get(r, 1);
+    int i;
+    if (count > max_count) {
+        r->ok = 0;
+        return 0;
+    }
+    for (i = 0; i < count; i++) notes[i] = (uint8_t)(blob_get(r, 1) & 0x7F);
+    return r->ok ? count : 0;
+}
+
+static uint64_t double_bits(double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+static double bits_double(uint64_t bits) {
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+static int export_runtime_state(const eucalypso_instance_t *inst, uint8_t *out, int cap) {
+    blob_writer_t w;
+    int i;
+    if (!inst || !out) return -1;
+    w.buf = out;
+    w.len = 0;
+    w.cap = cap;
+    w.ok = 1;
+    blob_put(&w, RUNTIME_BLOB_MAGIC, 4);
+    blob_put(&w, RUNTIME_BLOB_VERSION, 1);
+    blob_put(&w, (uint64_t)inst->sync_mode, 1);
+    blob_put(&w, (uint64_t)inst->sample_rate, 4);
+    blob_put(&w, inst->anchor_step, 8);
+    blob_put(&w, inst->phrase_anchor_step, 8);
+    blob_put(&w, (uint64_t)inst->phrase_restart_pending, 1);
+    blob_put(&w, inst->clock_tick_total, 8);
+    blob_put(&w, (uint64_t)inst->pending_step_triggers, 2);
+    blob_put(&w, (uint64_t)inst->clock_running, 1);
+    blob_put(&w, (uint64_t)inst->midi_transport_started, 1);
+    blob_put(&w, inst->internal_flicks, 8);
+    blob_put(&w, double_bits(inst->flicks_until_step), 8);
+    blob_put(&w, (uint64_t)inst->swing_phase, 1);
+    blob_put(&w, (uint64_t)inst->latch_ready_replace, 1);
+    /* Clock swing delays are measured from the smoothed clock interval. */
+    blob_put(&w, double_bits(inst->clock_interval_f), 8);
+    blob_put(&w, (uint64_t)(inst->clock_stamp_valid && !inst->clock_lost), 1);
+    blob_put(&w, inst->flick_clock > inst->clock_stamp_flicks ? inst->flick_clock - inst->clock_stamp_flicks : 0, 8);
+    blob_put(&w, (uint64_t)inst->clock_ticks_since_stamp, 2);
+    blob_put_notes(&w, inst->physical_notes, inst->physical_count);
+    blob_put_notes(&w, inst->physical_as_played, inst->physical_as_played_count);
+    blob_put_notes(&w, inst->active_notes, inst->active_count);
+    blob_put_notes(&w, inst->active_as_played, inst->active_as_played_count);
+    /* Captured events are raw bytes: bit 7 marks a note-on. */
+    blob_put(&w, (uint64_t)inst->capture_count, 1);
+    for (i = 0; i < inst->capture_count; i++) blob_put(&w, inst->capture_events[i], 1);
+    blob_put(&w, inst->capture_count > 0 && inst->capture_deadline > inst->flick_clock
+                     ? inst->capture_deadline - inst->flick_clock : 0, 8);
+    blob_put(&w, (uint64_t)inst->voice_count, 1);
+    for (i = 0; i < inst->voice_count; i++) {
+        blob_put(&w, inst->voice_notes[i], 1);
+        blob_put(&w, inst->voice_chan[i], 1);
+        blob_put(&w, (uint32_t)inst->voice_clock_left[i], 4);
+        blob_put(&w, (uint64_t)inst->voice_time_left[i], 8);
+    }
+    /* Queued notes keep their delay relative to now, like the capture. */
+    blob_put(&w, (uint64_t)inst->pending_count, 1);
+    for (i = 0; i < inst->pending_count; i++) {
+        blob_put(&w, inst->pending_at[i] > inst->flick_clock ? inst->pending_at[i] - inst->flick_clock : 0, 8);
+        blob_put(&w, inst->pending_note[i], 1);
+        blob_put(&w, inst->pending_velocity[i], 1);
+        blob_put(&w, (uint32_t)inst->pending_gate[i], 4);
+        blob_put(&w, inst->pending_chan[i], 1);
+    }
+    blob_put(&w, (uint32_t)inst->song_entry, 4);
+    blob_put(&w, (uint64_t)inst->song_repeat_left, 1);
+    blob_put(&w, (uint32_t)inst->song_steps_left, 4);
+    blob_put(&w, (uint64_t)inst->ramp_active, 1);
+    blob_put(&w, double_bits(inst->ramp_from_bpm), 8);
+    blob_put(&w, double_bits(inst->ramp_to_bpm), 8);
+    blob_put(&w, double_bits(inst->ramp_length_beats), 8);
+    blob_put(&w, double_bits(inst->ramp_beat), 8);
+    return w.ok ? w.len : -1;
+}
+
+static int import_runtime_state(eucalypso_instance_t *inst, const uint8_t *blob, int len) {
+    runtime_snapshot_t snap;
+    blob_reader_t r;
+    int i;
+    if (!inst || !blob) return 0;
+    r.buf = blob;
+    r.len = len;
+    r.pos = 0;
+    r.ok = 1;
+    if (blob_get(&r, 4) != RUNTIME_BLOB_MAGIC || blob_get(&r, 1) != RUNTIME_BLOB_VERSION) return 0;
+
+    /* Decode fully before touching the instance so a bad blob is a no-op. */
+    memset(&snap, 0, sizeof(snap));
+    if ((sync_mode_t)blob_get(&r, 1) != inst->sync_mode) return 0;
+    snap.sample_rate = (int)blob_get(&r, 4);
+    snap.anchor_step = blob_get(&r, 8);
+    snap.phrase_anchor_step = blob_get(&r, 8);
+    snap.phrase_restart_pending = blob_get(&r, 1) ? 1 : 0;
+    snap.clock_tick_total = blob_get(&r, 8);
+    snap.pending_step_triggers = clamp_int((int)blob_get(&r, 2), 0, 1024);
+    snap.clock_running = blob_get(&r, 1) ? 1 : 0;
+    snap.midi_transport_started = blob_get(&r, 1) ? 1 : 0;
+    snap.internal_flicks = blob_get(&r, 8);
+    snap.flicks_until_step = bits_double(blob_get(&r, 8));
+    snap.swing_phase = blob_get(&r, 1) ? 1 : 0;
+    snap.latch_ready_replace = blob_get(&r, 1) ? 1 : 0;
+    snap.clock_interval_f = bits_double(blob_get(&r, 8));
+    snap.clock_stamp_valid = blob_get(&r, 1) ? 1 : 0;
+    snap.clock_stamp_age = blob_get(&r, 8);
+    snap.clock_ticks_since_stamp = (int)blob_get(&r, 2);
+    snap.physical_count = blob_get_notes(&r, snap.physical_notes, MAX_HELD_NOTES);
+    snap.physical_as_played_count = blob_get_notes(&r, snap.physical_as_played, MAX_HELD_NOTES);
+    snap.active_count = blob_get_notes(&r, snap.active_notes, MAX_HELD_NOTES);
+    snap.active_as_played_count = blob_get_notes(&r, snap.active_as_played, MAX_HELD_NOTES);
+    snap.capture_count = (int)blob_get(&r, 1);
+    if (snap.capture_count > MAX_CAPTURE_EVENTS) return 0;
+    for (i = 0; i < snap.capture_count; i++) snap.capture_events[i] = (uint8_t)blob_get(&r, 1);
+    snap.capture_left = blob_get(&r, 8);
+    snap.voice_count = (int)blob_get(&r, 1);
+    if (snap.voice_count > MAX_VOICES) return 0;
+    for (i = 0; i < snap.voice_count; i++) {
+        snap.voice_notes[i] = (uint8_t)(blob_get(&r, 1) & 0x7F);
+        snap.voice_chan[i] = (uint8_t)(blob_get(&r, 1) & 0x0F);
+        snap.voice_clock_left[i] = (int)(int32_t)(uint32_t)blob_get(&r, 4);
+        snap.voice_time_left[i] = (int64_t)blob_get(&r, 8);
+    }
+    snap.pending_count = (int)blob_get(&r, 1);
+    if (snap.pending_count > MAX_PENDING_NOTES) return 0;
+    for (i = 0; i < snap.pending_count; i++) {
+        snap.pending_left[i] = blob_get(&r, 8);
+        snap.pending_note[i] = (uint8_t)(blob_get(&r, 1) & 0x7F);
+        snap.pending_velocity[i] = (uint8_t)clamp_int((int)blob_get(&r, 1), 1, 127);
+        snap.pending_gate[i] = clamp_int((int)(int32_t)(uint32_t)blob_get(&r, 4), 0, MAX_VOICE_GATE_PCT);
+        snap.pending_chan[i] = (uint8_t)clamp_int((int)blob_get(&r, 1), 0, 16);
+    }
+    snap.song_entry = (int)(int32_t)(uint32_t)blob_get(&r, 4);
+    snap.song_repeat_left = (int)blob_get(&r, 1);
+    snap.song_steps_left = (int)(int32_t)(uint32_t)blob_get(&r, 4);
+    if (snap.song_entry >= inst->song_list->count) snap.song_entry = -1;
+    snap.ramp_active = blob_get(&r, 1) ? 1 : 0;
+    snap.ramp_from_bpm = bits_double(blob_get(&r, 8));
+    snap.ramp_to_bpm = bits_double(blob_get(&r, 8));
+    snap.ramp_length_beats = bits_double(blob_get(&r, 8));
+    snap.ramp_beat = bits_double(blob_get(&r, 8));
+    if (snap.ramp_active &&
+        !(snap.ramp_from_bpm >= 1.0 && snap.ramp_to_bpm >= 1.0 && snap.ramp_length_beats > 0.0 &&
+          snap.ramp_beat >= 0.0 && snap.ramp_beat < snap.ramp_length_beats)) {
+        snap.ramp_active = 0;
+    }
+    if (!r.ok) return 0;
+    if (!(snap.clock_interval_f > 0.0 && snap.clock_interval_f < 1e15)) {
+        snap.clock_interval_f = 0.0;
+        snap.clock_stamp_valid = 0;
+    }
+    if (!(snap.flicks_until_step > 0.0 && snap.flicks_until_step < 1e15)) {
+        snap.flicks_until_step = inst->step_interval_flicks > 0.0 ? inst->step_interval_flicks : 1.0;
+    }
+
+    /* Settle timing first so the next tick does not re-clamp the phase. */
+    if (inst->sample_rate <= 0 && snap.sample_rate > 0) {
+        recalc_internal_timing(inst, snap.sample_rate);
+    } else if (inst->timing_dirty && inst->sample_rate > 0) {
+        recalc_internal_timing(inst, inst->sample_rate);
+    }
+
+    inst->anchor_step = snap.anchor_step;
+    inst->phrase_anchor_step = snap.phrase_anchor_step;
+    inst->phrase_restart_pending = snap.phrase_restart_pending;
+    inst->clock_tick_total = snap.clock_tick_total;
+    inst->clock_counter = (int)(snap.clock_tick_total %
+                                (uint64_t)(inst->clocks_per_step > 0 ? inst->clocks_per_step : 1));
+    inst->pending_step_triggers = snap.pending_step_triggers;
+    inst->clock_running = snap.clock_running;
+    inst->midi_transport_started = snap.midi_transport_started;
+    inst->internal_flicks = snap.internal_flicks;
+    inst->flicks_until_step = snap.flicks_until_step;
+    inst->swing_phase = snap.swing_phase;
+    inst->latch_ready_replace = snap.latch_ready_replace;
+    inst->clock_interval_f = snap.clock_interval_f;
+    inst->clock_stamp_valid = snap.clock_stamp_valid;
+    /* A fresh instance's flick clock may be younger than the stamp; only
+     * differences of it are meaningful, so move it forward. */
+    if (inst->flick_clock < snap.clock_stamp_age) inst->flick_clock = snap.clock_stamp_age;
+    inst->clock_stamp_flicks = inst->flick_clock - snap.clock_stamp_age;
+    inst->clock_ticks_since_stamp = snap.clock_ticks_since_stamp;
+    inst->clock_lost = 0;
+    memcpy(inst->physical_notes, snap.physical_notes, sizeof(inst->physical_notes));
+    inst->physical_count = snap.physical_count;
+    memcpy(inst->physical_as_played, snap.physical_as_played, sizeof(inst->physical_as_played));
+    inst->physical_as_played_count = snap.physical_as_played_count;
+    memcpy(inst->active_notes, snap.active_notes, sizeof(inst->active_notes));
+    inst->active_count = snap.active_count;
+    memcpy(inst->active_as_played, snap.active_as_played, sizeof(inst->active_as_played));
+    inst->active_as_played_count = snap.active_as_played_count;
+    memcpy(inst->capture_events, snap.capture_events, sizeof(inst->capture_events));
+    inst->capture_count = snap.capture_count;
+    inst->capture_deadline = inst->flick_clock + snap.capture_left;
+    memcpy(inst->voice_notes, snap.voice_notes, sizeof(inst->voice_notes));
+    memcpy(inst->voice_clock_left, snap.voice_clock_left, sizeof(inst->voice_clock_left));
+    memcpy(inst->voice_time_left, snap.voice_time_left, sizeof(inst->voice_time_left));
+    memcpy(inst->voice_chan, snap.voice_chan, sizeof(inst->voice_chan));
+    inst->voice_count = snap.voice_count;
+    memset(inst->chan_voices, 0, sizeof(inst->chan_voices));
+    inst->chan_busy = 0;
+    for (i = 0; i < inst->voice_count; i++) {
+        inst->chan_voices[inst->voice_chan[i]]++;
+        inst->chan_busy |= 1u << inst->voice_chan[i];
+    }
+    for (i = 0; i < snap.pending_count; i++) {
+        inst->pending_at[i] = inst->flick_clock + snap.pending_left[i];
+        inst->pending_note[i] = snap.pending_note[i];
+        inst->pending_velocity[i] = snap.pending_velocity[i];
+        inst->pending_gate[i] = snap.pending_gate[i];
+        inst->pending_chan[i] = snap.pending_chan[i];
+    }
+    inst->pending_count = snap.pending_count;
+    /* The position belongs to the list already loaded with "state". */
+    inst->song_seen_gen = inst->song_list->gen;
+    inst->song_entry = snap.song_entry < 0 ? -1 : snap.song_entry;
+    inst->song_repeat_left = snap.song_repeat_left;
+    inst->song_steps_left = snap.song_entry < 0 ? 0 : snap.song_steps_left;
+    inst->ramp_active = snap.ramp_active && inst->sync_mode == SYNC_INTERNAL;
+    inst->ramp_from_bpm = snap.ramp_from_bpm;
+    inst->ramp_to_bpm = snap.ramp_to_bpm;
+    inst->ramp_length_beats = snap.ramp_length_beats;
+    inst->ramp_beat = snap.ramp_beat;
+    dlog(inst, "runtime state imported anchor=%llu voices=%d",
+         (unsigned long long)inst->anchor_step, inst->voice_count);
+    return 1;
+}
+
+static int hex_nibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static int hex_encode(const uint8_t *data, int len, char *buf, int buf_len) {
+    static const char k_hex[] = "0123456789abcdef";
+    int i;
+    if (len < 0 || len * 2 + 1 > buf_len) return -1;
+    for (i = 0; i < len; i++) {
+        buf[i * 2] = k_hex[data[i] >> 4];
+        buf[i * 2 + 1] = k_hex[data[i] & 0x0F];
+    }
+    buf[len * 2] = '\0';
+    return len * 2;
+}
+
+static int get_runtime_state_hex(const eucalypso_instance_t *inst, char *buf, int buf_len) {
+    uint8_t blob[RUNTIME_BLOB_MAX];
+    int len = export_runtime_state(inst, blob, (int)sizeof(blob));
+    return hex_encode(blob, len, buf, buf_len);
+}
+
+static void set_runtime_state_hex(eucalypso_instance_t *inst, const char *val) {
+    uint8_t blob[RUNTIME_BLOB_MAX];
+    int len = 0;
+    if (!inst || !val) return;
+    while (val[0] && val[1] && len < (int)sizeof(blob)) {
+        int hi = hex_nibble(val[0]);
+        int lo = hex_nibble(val[1]);
+        if (hi < 0 || lo < 0) return;
+        blob[len++] = (uint8_t)((hi << 4) | lo);
+        val += 2;
+    }
+    if (val[0]) return;
+    (void)import_runtime_state(inst, blob, len);
+}
+
+/* Serializes the current parameters as a preset block; the packer reads this
+ * back through get_param("preset_block") so the field order lives here only. */
+static int get_param_block_hex(const eucalypso_instance_t *inst, char *buf, int buf_len) {
+    uint8_t block[(PRESET_GLOBAL_FIELD_COUNT + MAX_LANES * PRESET_LANE_FIELD_COUNT) * 4];
+    int f = 0;
+    int i;
+    int l;
+    for (i = 0; i < PRESET_GLOBAL_FIELD_COUNT; i++, f++) {
+        int v;
+        memcpy(&v, (const char *)inst + k_preset_global_fields[i].offset, sizeof(v));
+        write_le32(block + f * 4, (uint32_t)v);
+    }
+    for (l = 0; l < MAX_LANES; l++) {
+        for (i = 0; i < PRESET_LANE_FIELD_COUNT; i++, f++) {
+            int v;
+            memcpy(&v, (const char *)&inst->parts[0].lanes[l] + k_preset_lane_fields[i].offset, sizeof(v));
+            write_le32(block + f * 4, (uint32_t)v);
+        }
+    }
+    return hex_encode(block, f * 4, buf, buf_len);
+}
+
+static int load_preset_index(eucalypso_instance_t *inst, int idx) {
+    const preset_lib_t *lib = preset_lib_get();
+    const uint8_t *block = preset_block(lib, idx);
+    if (!inst || !block) return 0;
+    apply_param_block(inst, block, (int)lib->fields);
+    snprintf(inst->preset_name, sizeof(inst->preset_name), "%s", (const char *)preset_entry(lib, idx));
+    dlog(inst, "preset loaded idx=%d name=%s", idx, inst->preset_name);
+    return 1;
+}
+
+/* Parses "slot:bars:repeat,..." (bars and repeat default to 1) and resolves
+ * each slot to its library block up front. */
+static void set_song_list(eucalypso_instance_t *inst, const char *val) {
+    const preset_lib_t *lib = preset_lib_get();
+    const char *p = val;
+    song_list_t *next;
+    int count = 0;
+    if (!inst || !val) return;
+    next = song_staging(inst);
+    while (*p && count < MAX_SONG_ENTRIES) {
+        char *end;
+        long slot = strtol(p, &end, 10);
+        long bars = 1;
+        long repeat = 1;
+        if (end == p) break;
+        p = end;
+        if (*p == ':') {
+            bars = strtol(p + 1, &end, 10);
+            p = end;
+            if (*p == ':') {
+                repeat = strtol(p + 1, &end, 10);
+                p = end;
+            }
+        }
+        next->slot[count] = (int)slot;
+        next->bars[count] = clamp_int((int)bars, 1, 256);
+        next->repeat[count] = clamp_int((int)repeat, 1, 64);
+        next->block[count] = preset_block(lib, (int)slot);
+        count++;
+        while (*p == ',' || *p == ' ') p++;
+    }
+    next->block_fields = lib ? (int)lib->fields : 0;
+    next->count = count;
+    song_publish(inst, next);
+}
+
+/* Republishes the current list unchanged, so the audio thread rewinds. */
+static void song_restart(eucalypso_instance_t *inst) {
+    song_list_t *next = song_staging(inst);
+    *next = *__atomic_load_n(&inst->song_list, __ATOMIC_ACQUIRE);
+    song_publish(inst, next);
+}
+
+static int format_song_list(const eucalypso_instance_t *inst, char *buf, int buf_len) {
+    const song_list_t *list = __atomic_load_n(&inst->song_list, __ATOMIC_ACQUIRE);
+    int pos = 0;
+    int i;
+    buf[0] = '\0';
+    for (i = 0; i < list->count; i++) {
+        if (!appendf(buf, buf_len, &pos, "%s%d:%d:%d", i > 0 ? "," : "",
+                     list->slot[i], list->bars[i], list->repeat[i])) {
+            return -1;
+        }
+    }
+    return pos;
+}
+
 static int parse_lane_key(const char *key, int *lane_idx, const char **suffix) {
     int lane_num;
     int consumed = 0;
@@ -1368,12 +3577,6 @@ static int parse_lane_key(const char *key, int *lane_idx, const char **suffix) {
     return 1;
 }
 
-static void normalize_lane(lane_t *lane) {
-    if (!lane) return;
-    lane->steps = clamp_int(lane->steps, 1, 128);
-    lane->pulses = clamp_int(lane->pulses, 0, lane->steps);
-}
-
 static void set_lane_param(lane_t *lane, const char *suffix, const char *val) {
     if (!lane || !suffix || !val) return;
     if (strcmp(suffix, "enabled") == 0) lane->enabled = strcmp(val, "on") == 0 ? 1 : 0;
@@ -1398,6 +3601,15 @@ static void set_lane_param(lane_t *lane, const char *suffix, const char *val) {
     }
     else if (strcmp(suffix, "velocity") == 0) lane->velocity = clamp_int(atoi(val), 0, 127);
     else if (strcmp(suffix, "gate") == 0) lane->gate = clamp_int(atoi(val), 0, 1600);
+    else if (strcmp(suffix, "early_ms") == 0) lane->early_ms = clamp_int(atoi(val), 0, MAX_EARLY_MS);
+    else if (strcmp(suffix, "dir") == 0) {
+        if (strcmp(val, "fwd") == 0) lane->direction = DIR_FORWARD;
+        else if (strcmp(val, "rev") == 0) lane->direction = DIR_REVERSE;
+        else if (strcmp(val, "pingpong") == 0) lane->direction = DIR_PINGPONG;
+        else if (strcmp(val, "rand") == 0) lane->direction = DIR_RANDOM;
+    }
+    else if (strcmp(suffix, "dir_seed") == 0) lane->dir_seed = clamp_int(atoi(val), 0, 65535);
+    else if (strcmp(suffix, "legato") == 0) lane->legato = strcmp(val, "on") == 0 ? 1 : 0;
     normalize_lane(lane);
 }
 
@@ -1422,117 +3634,403 @@ static int get_lane_param(const lane_t *lane, const char *suffix, char *buf, int
     }
     if (strcmp(suffix, "velocity") == 0) return snprintf(buf, buf_len, "%d", lane->velocity);
     if (strcmp(suffix, "gate") == 0) return snprintf(buf, buf_len, "%d", lane->gate);
+    if (strcmp(suffix, "early_ms") == 0) return snprintf(buf, buf_len, "%d", lane->early_ms);
+    if (strcmp(suffix, "dir") == 0) return snprintf(buf, buf_len, "%s", direction_to_string(lane->direction));
+    if (strcmp(suffix, "dir_seed") == 0) return snprintf(buf, buf_len, "%d", lane->dir_seed);
+    if (strcmp(suffix, "legato") == 0) return snprintf(buf, buf_len, "%s", lane->legato ? "on" : "off");
+    return -1;
+}
+
+/*
+ * Bulk lane operations. Each one rewrites whole lane_t records inside a
+ * single set_param call instead of a set_param per field, so no step sees a
+ * half-copied lane and each affected lane is normalized once.
+ *
+ *   lane_copy       "src:dst"
+ *   lane_swap       "a:b"
+ *   lane_reset      "N" or "all"
+ *   lane_randomize  "N:seed" or "all:seed" (new drop/note/octave seeds)
+ */
+static int parse_lane_pair(const char *val, int *a, int *b) {
+    int x;
+    int y;
+    if (!val || sscanf(val, "%d:%d", &x, &y) != 2) return 0;
+    if (x < 1 || x > MAX_LANES || y < 1 || y > MAX_LANES) return 0;
+    *a = x - 1;
+    *b = y - 1;
+    return 1;
+}
+
+/* Returns a bitmask of the lanes named by "N" or "all"; *rest points past
+ * an optional ':' separator. */
+static int parse_lane_target(const char *val, const char **rest) {
+    int mask = 0;
+    int n;
+    int consumed = 0;
+    if (!val) return 0;
+    if (strncmp(val, "all", 3) == 0) {
+        mask = (1 << MAX_LANES) - 1;
+        consumed = 3;
+    } else if (sscanf(val, "%d%n", &n, &consumed) == 1 && n >= 1 && n <= MAX_LANES) {
+        mask = 1 << (n - 1);
+    } else {
+        return 0;
+    }
+    val += consumed;
+    if (*val == ':') val++;
+    else if (*val != '\0') return 0;
+    if (rest) *rest = val;
+    return mask;
+}
+
+static void randomize_lane_seeds(lane_t *lane, int lane_idx, uint32_t seed) {
+    uint32_t s = mix_u32(seed);
+    lane->drop_seed = (int)(step_rand_u32(s, (uint64_t)lane_idx, 0x3001u) & 0xFFFFu);
+    lane->n_seed = (int)(step_rand_u32(s, (uint64_t)lane_idx, 0x3002u) & 0xFFFFu);
+    lane->oct_seed = (int)(step_rand_u32(s, (uint64_t)lane_idx, 0x3003u) & 0xFFFFu);
+    lane->dir_seed = (int)(step_rand_u32(s, (uint64_t)lane_idx, 0x3004u) & 0xFFFFu);
+}
+
+static int apply_lane_op(eucalypso_instance_t *inst, part_t *part, const char *key, const char *val) {
+    int a;
+    int b;
+    int mask;
+    int i;
+    const char *rest = NULL;
+    if (strcmp(key, "lane_copy") == 0) {
+        if (!parse_lane_pair(val, &a, &b)) return 1;
+        if (a != b) {
+            part->lanes[b] = part->lanes[a];
+            normalize_lane(&part->lanes[b]);
+        }
+    } else if (strcmp(key, "lane_swap") == 0) {
+        lane_t tmp;
+        if (!parse_lane_pair(val, &a, &b)) return 1;
+        tmp = part->lanes[a];
+        part->lanes[a] = part->lanes[b];
+        part->lanes[b] = tmp;
+    } else if (strcmp(key, "lane_reset") == 0) {
+        mask = parse_lane_target(val, &rest);
+        if (!mask || *rest != '\0') return 1;
+        for (i = 0; i < MAX_LANES; i++) {
+            if (mask & (1 << i)) reset_lane(&part->lanes[i], i);
+        }
+    } else if (strcmp(key, "lane_randomize") == 0) {
+        uint32_t seed;
+        mask = parse_lane_target(val, &rest);
+        if (!mask) return 1;
+        seed = (uint32_t)strtoul(rest, NULL, 10);
+        for (i = 0; i < MAX_LANES; i++) {
+            if (mask & (1 << i)) randomize_lane_seeds(&part->lanes[i], i, seed);
+        }
+    } else {
+        return 0;
+    }
+    dlog(inst, "%s %s", key, val);
+    return 1;
+}
+
+static int parse_part_key(const char *key, int *part_idx, const char **rest) {
+    int part_num;
+    int consumed = 0;
+    if (!key || !part_idx || !rest) return 0;
+    if (sscanf(key, "part%d_%n", &part_num, &consumed) != 1 || consumed == 0) return 0;
+    if (part_num < 1 || part_num > MAX_PARTS) return 0;
+    *part_idx = part_num - 1;
+    *rest = key + consumed;
+    return 1;
+}
+
+/* Register settings and the output channel belong to a part. Returns 0 for
+ * keys that are not part-scoped. */
+static int set_part_param(part_t *part, const char *key, const char *val) {
+    if (strcmp(key, "register_mode") == 0) {
+        if (strcmp(val, "scale") == 0) part->register_mode = REGISTER_SCALE;
+        else if (strcmp(val, "drumpad") == 0) part->register_mode = REGISTER_DRUMPAD;
+        else part->register_mode = REGISTER_HELD;
+    }
+    else if (strcmp(key, "held_order") == 0) {
+        if (strcmp(val, "down") == 0) part->held_order = HELD_DOWN;
+        else if (strcmp(val, "played") == 0) part->held_order = HELD_PLAYED;
+        else if (strcmp(val, "rand") == 0) part->held_order = HELD_RAND;
+        else part->held_order = HELD_UP;
+    }
+    else if (strcmp(key, "held_order_seed") == 0) part->held_order_seed = clamp_int(atoi(val), 0, 65535);
+    else if (strcmp(key, "missing_note_policy") == 0) {
+        if (strcmp(val, "fold") == 0) part->missing_note_policy = MISSING_FOLD;
+        else if (strcmp(val, "wrap") == 0) part->missing_note_policy = MISSING_WRAP;
+        else if (strcmp(val, "random") == 0) part->missing_note_policy = MISSING_RANDOM;
+        else part->missing_note_policy = MISSING_SKIP;
+    }
+    else if (strcmp(key, "missing_note_seed") == 0) part->missing_note_seed = clamp_int(atoi(val), 0, 65535);
+    else if (strcmp(key, "scale_mode") == 0) {
+        if (strcmp(val, "natural_minor") == 0) part->scale_mode = SCALE_NATURAL_MINOR;
+        else if (strcmp(val, "harmonic_minor") == 0) part->scale_mode = SCALE_HARMONIC_MINOR;
+        else if (strcmp(val, "melodic_minor") == 0) part->scale_mode = SCALE_MELODIC_MINOR;
+        else if (strcmp(val, "dorian") == 0) part->scale_mode = SCALE_DORIAN;
+        else if (strcmp(val, "phrygian") == 0) part->scale_mode = SCALE_PHRYGIAN;
+        else if (strcmp(val, "lydian") == 0) part->scale_mode = SCALE_LYDIAN;
+        else if (strcmp(val, "mixolydian") == 0) part->scale_mode = SCALE_MIXOLYDIAN;
+        else if (strcmp(val, "locrian") == 0) part->scale_mode = SCALE_LOCRIAN;
+        else if (strcmp(val, "pentatonic_major") == 0) part->scale_mode = SCALE_PENTATONIC_MAJOR;
+        else if (strcmp(val, "pentatonic_minor") == 0) part->scale_mode = SCALE_PENTATONIC_MINOR;
+        else if (strcmp(val, "blues") == 0) part->scale_mode = SCALE_BLUES;
+        else if (strcmp(val, "whole_tone") == 0) part->scale_mode = SCALE_WHOLE_TONE;
+        else if (strcmp(val, "chromatic") == 0) part->scale_mode = SCALE_CHROMATIC;
+        else part->scale_mode = SCALE_MAJOR;
+    }
+    else if (strcmp(key, "scale_rng") == 0) part->scale_rng = clamp_int(atoi(val), 1, 24);
+    else if (strcmp(key, "root_note") == 0) part->root_note = clamp_int(atoi(val), 0, 11);
+    else if (strcmp(key, "octave") == 0) part->octave = clamp_int(atoi(val), -3, 3);
+    else if (strcmp(key, "part_chan") == 0) part->out_chan = strcmp(val, "auto") == 0 ? 0 : clamp_int(atoi(val), 0, 16);
+    else return 0;
+    return 1;
+}
+
+/* Returns -1 for keys that are not part-scoped. */
+static int get_part_param(const part_t *part, const char *key, char *buf, int buf_len) {
+    if (strcmp(key, "register_mode") == 0) return snprintf(buf, buf_len, "%s", register_mode_to_string(part->register_mode));
+    if (strcmp(key, "held_order") == 0) return snprintf(buf, buf_len, "%s", held_order_to_string(part->held_order));
+    if (strcmp(key, "held_order_seed") == 0) return snprintf(buf, buf_len, "%d", part->held_order_seed);
+    if (strcmp(key, "missing_note_policy") == 0) return snprintf(buf, buf_len, "%s", missing_note_policy_to_string(part->missing_note_policy));
+    if (strcmp(key, "missing_note_seed") == 0) return snprintf(buf, buf_len, "%d", part->missing_note_seed);
+    if (strcmp(key, "scale_mode") == 0) return snprintf(buf, buf_len, "%s", scale_mode_to_string(part->scale_mode));
+    if (strcmp(key, "scale_rng") == 0) return snprintf(buf, buf_len, "%d", part->scale_rng);
+    if (strcmp(key, "root_note") == 0) return snprintf(buf, buf_len, "%d", part->root_note);
+    if (strcmp(key, "octave") == 0) return snprintf(buf, buf_len, "%d", part->octave);
+    if (strcmp(key, "part_chan") == 0) {
+        if (part->out_chan <= 0) return snprintf(buf, buf_len, "auto");
+        return snprintf(buf, buf_len, "%d", part->out_chan);
+    }
     return -1;
 }
 
+/*
+ * State keys of a part: its register settings, then every lane field. Parts
+ * after the first are saved as partN_ keys, and only where they differ from a
+ * fresh part, so a single-part state is unchanged.
+ */
+static const char *const k_part_state_keys[] = {
+    "register_mode", "held_order", "held_order_seed", "missing_note_policy", "missing_note_seed",
+    "scale_mode", "scale_rng", "root_note", "octave", "part_chan"
+};
+
+static const char *const k_lane_state_fields[] = {
+    "enabled", "steps", "pulses", "rotation", "drop", "drop_seed",
+    "note", "n_rnd", "n_seed", "octave", "oct_rnd", "oct_seed",
+    "oct_rng", "velocity", "gate", "early_ms", "dir", "dir_seed", "legato"
+};
+
+static int state_field_is_string(const char *field) {
+    static const char *const k_string_fields[] = {
+        "register_mode", "held_order", "missing_note_policy", "scale_mode", "part_chan",
+        "enabled", "oct_rng", "dir", "legato"
+    };
+    int i;
+    for (i = 0; i < (int)(sizeof(k_string_fields) / sizeof(k_string_fields[0])); i++) {
+        if (strcmp(field, k_string_fields[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+/* Reads key as a quoted or numeric value depending on field, formatted for
+ * set_param. */
+static int json_get_field(const char *json, const char *key, const char *field, char *out, int out_len) {
+    int parsed;
+    if (state_field_is_string(field)) return json_get_string(json, key, out, out_len) > 0;
+    if (!json_get_int(json, key, &parsed)) return 0;
+    snprintf(out, (size_t)out_len, "%d", parsed);
+    return 1;
+}
+
+static int append_part_field(char *buf, int buf_len, int *pos, int part_idx, const char *key,
+                             const char *field, const char *val) {
+    const char *q = state_field_is_string(field) ? "\"" : "";
+    return appendf(buf, buf_len, pos, ",\"part%d_%s\":%s%s%s", part_idx + 1, key, q, val, q);
+}
+
+static int append_part_state(const part_t *part, int part_idx, char *buf, int buf_len, int *pos) {
+    part_t fresh;
+    char val[32];
+    char ref[32];
+    char key[32];
+    int i;
+    int l;
+    reset_part(&fresh, part_idx);
+    for (i = 0; i < (int)(sizeof(k_part_state_keys) / sizeof(k_part_state_keys[0])); i++) {
+        const char *k = k_part_state_keys[i];
+        if (get_part_param(part, k, val, sizeof(val)) < 0) continue;
+        (void)get_part_param(&fresh, k, ref, sizeof(ref));
+        if (strcmp(val, ref) == 0) continue;
+        if (!append_part_field(buf, buf_len, pos, part_idx, k, k, val)) return 0;
+    }
+    for (l = 0; l < MAX_LANES; l++) {
+        for (i = 0; i < (int)(sizeof(k_lane_state_fields) / sizeof(k_lane_state_fields[0])); i++) {
+            const char *f = k_lane_state_fields[i];
+            if (get_lane_param(&part->lanes[l], f, val, sizeof(val)) < 0) continue;
+            (void)get_lane_param(&fresh.lanes[l], f, ref, sizeof(ref));
+            if (strcmp(val, ref) == 0) continue;
+            snprintf(key, sizeof(key), "lane%d_%s", l + 1, f);
+            if (!append_part_field(buf, buf_len, pos, part_idx, key, f, val)) return 0;
+        }
+    }
+    return 1;
+}
+
 static void eucalypso_set_param(void *instance, const char *key, const char *val) {
     eucalypso_instance_t *inst = (eucalypso_instance_t *)instance;
+    part_t *part;
+    int part_idx;
     int lane_idx;
     const char *suffix;
+    int prefixed;
     if (!inst || !key || !val) return;
 
+    /* partN_<key> addresses part N; unprefixed keys the edited part. */
+    prefixed = parse_part_key(key, &part_idx, &suffix);
+    if (prefixed) key = suffix;
+    else part_idx = inst->part_edit;
+    part = &inst->parts[part_idx];
     if (parse_lane_key(key, &lane_idx, &suffix)) {
-        set_lane_param(&inst->lanes[lane_idx], suffix, val);
+        set_lane_param(&part->lanes[lane_idx], suffix, val);
         return;
     }
+    if (strncmp(key, "lane_", 5) == 0 && apply_lane_op(inst, part, key, val)) return;
+    if (set_part_param(part, key, val) || prefixed) return;
 
     if (strcmp(key, "play_mode") == 0) set_play_mode(inst, strcmp(val, "latch") == 0 ? PLAY_LATCH : PLAY_HOLD);
     else if (strcmp(key, "retrigger_mode") == 0) inst->retrigger_mode = strcmp(val, "cont") == 0 ? RETRIG_CONT : RETRIG_RESTART;
     else if (strcmp(key, "rate") == 0) {
         inst->rate = parse_rate(val);
-        inst->timing_dirty = 1;
-        recalc_clock_timing(inst);
-        if (inst->sync_mode == SYNC_CLOCK) realign_clock_phase(inst);
-        else if (inst->sample_rate > 0) {
-            recalc_internal_timing(inst, inst->sample_rate);
-            realign_internal_phase(inst);
-        }
+        retime_after_rate_change(inst);
     }
     else if (strcmp(key, "sync") == 0) {
-        inst->sync_mode = strcmp(val, "clock") == 0 ? SYNC_CLOCK : SYNC_INTERNAL;
-        if (inst->sync_mode == SYNC_CLOCK) {
-            recalc_clock_timing(inst);
-            realign_clock_phase(inst);
-            inst->clock_running = 1;
+        if (strcmp(val, "clock") == 0) set_sync_mode(inst, SYNC_CLOCK);
+        else if (strcmp(val, "note") == 0) set_sync_mode(inst, SYNC_NOTE);
+        else set_sync_mode(inst, SYNC_INTERNAL);
+    }
+    else if (strcmp(key, "trig_note") == 0) inst->trig_note = clamp_int(atoi(val), 0, 127);
+    else if (strcmp(key, "trig_chan") == 0) inst->trig_chan = strcmp(val, "any") == 0 ? 0 : clamp_int(atoi(val), 0, 16);
+    else if (strcmp(key, "bpm") == 0) {
+        double from = current_tempo(inst);
+        inst->bpm = clamp_int(atoi(val), 40, 240);
+        inst->ramp_active = 0;
+        if (inst->ramp_beats > 0 && inst->sync_mode == SYNC_INTERNAL && inst->sample_rate > 0 &&
+            from != (double)inst->bpm) {
+            start_tempo_ramp(inst, from);
         } else {
-            inst->clock_running = 1;
-            if (inst->sample_rate > 0) {
+            inst->timing_dirty = 1;
+            if (inst->sync_mode == SYNC_INTERNAL && inst->sample_rate > 0) {
                 recalc_internal_timing(inst, inst->sample_rate);
                 realign_internal_phase(inst);
             }
         }
     }
-    else if (strcmp(key, "bpm") == 0) {
-        inst->bpm = clamp_int(atoi(val), 40, 240);
-        inst->timing_dirty = 1;
-        if (inst->sync_mode == SYNC_INTERNAL && inst->sample_rate > 0) {
-            recalc_internal_timing(inst, inst->sample_rate);
-            realign_internal_phase(inst);
-        }
+    else if (strcmp(key, "ramp_beats") == 0) inst->ramp_beats = clamp_int(atoi(val), 0, 64);
+    else if (strcmp(key, "ramp_curve") == 0) inst->ramp_curve = strcmp(val, "exp") == 0 ? RAMP_EXP : RAMP_LINEAR;
+    else if (strcmp(key, "clock_loss_mult") == 0) inst->clock_loss_mult = clamp_int(atoi(val), 2, 64);
+    else if (strcmp(key, "catchup") == 0) {
+        if (strcmp(val, "latest") == 0) inst->catchup_policy = CATCHUP_LATEST;
+        else if (strcmp(val, "skip") == 0) inst->catchup_policy = CATCHUP_SKIP;
+        else inst->catchup_policy = CATCHUP_ALL;
+    }
+    else if (strcmp(key, "catchup_ms") == 0) inst->catchup_ms = clamp_int(atoi(val), 0, 1000);
+    else if (strcmp(key, "capture_ms") == 0) {
+        inst->capture_ms = clamp_int(atoi(val), 0, MAX_CAPTURE_MS);
+        if (inst->capture_ms == 0) capture_commit(inst);
+    }
+    else if (strcmp(key, "early_ms") == 0) {
+        inst->early_ms = clamp_int(atoi(val), 0, MAX_EARLY_MS);
+        update_early_lead(inst);
     }
     else if (strcmp(key, "swing") == 0) inst->swing = clamp_int(atoi(val), 0, 100);
     else if (strcmp(key, "max_voices") == 0) inst->max_voices = clamp_int(atoi(val), 1, MAX_VOICES);
+    else if (strcmp(key, "chan_mode") == 0) {
+        if (strcmp(val, "rr") == 0) inst->chan_mode = CHAN_ALLOC_ROUND_ROBIN;
+        else if (strcmp(val, "lru") == 0) inst->chan_mode = CHAN_ALLOC_LRU;
+        else inst->chan_mode = CHAN_ALLOC_OFF;
+    }
+    else if (strcmp(key, "chan_lo") == 0) inst->chan_lo = clamp_int(atoi(val), 1, 16);
+    else if (strcmp(key, "chan_hi") == 0) inst->chan_hi = clamp_int(atoi(val), 1, 16);
     else if (strcmp(key, "global_velocity") == 0) inst->global_velocity = clamp_int(atoi(val), 1, 127);
     else if (strcmp(key, "global_v_rnd") == 0) inst->global_v_rnd = clamp_int(atoi(val), 0, 127);
     else if (strcmp(key, "global_gate") == 0) inst->global_gate = clamp_int(atoi(val), 1, 1600);
     else if (strcmp(key, "global_g_rnd") == 0) inst->global_g_rnd = clamp_int(atoi(val), 0, 1600);
     else if (strcmp(key, "global_rnd_seed") == 0) inst->global_rnd_seed = clamp_int(atoi(val), 0, 65535);
     else if (strcmp(key, "rand_cycle") == 0) inst->rand_cycle = clamp_int(atoi(val), 1, 128);
-    else if (strcmp(key, "register_mode") == 0) {
-        if (strcmp(val, "scale") == 0) inst->register_mode = REGISTER_SCALE;
-        else if (strcmp(val, "drumpad") == 0) inst->register_mode = REGISTER_DRUMPAD;
-        else inst->register_mode = REGISTER_HELD;
+    else if (strcmp(key, "evolve") == 0) {
+        inst->evolve = clamp_int(atoi(val), 0, 100);
+        evolve_invalidate(inst);
     }
-    else if (strcmp(key, "held_order") == 0) {
-        if (strcmp(val, "down") == 0) inst->held_order = HELD_DOWN;
-        else if (strcmp(val, "played") == 0) inst->held_order = HELD_PLAYED;
-        else if (strcmp(val, "rand") == 0) inst->held_order = HELD_RAND;
-        else inst->held_order = HELD_UP;
+    else if (strcmp(key, "evolve_seed") == 0) {
+        inst->evolve_seed = clamp_int(atoi(val), 0, 65535);
+        evolve_invalidate(inst);
     }
-    else if (strcmp(key, "held_order_seed") == 0) inst->held_order_seed = clamp_int(atoi(val), 0, 65535);
-    else if (strcmp(key, "missing_note_policy") == 0) {
-        if (strcmp(val, "fold") == 0) inst->missing_note_policy = MISSING_FOLD;
-        else if (strcmp(val, "wrap") == 0) inst->missing_note_policy = MISSING_WRAP;
-        else if (strcmp(val, "random") == 0) inst->missing_note_policy = MISSING_RANDOM;
-        else inst->missing_note_policy = MISSING_SKIP;
+    else if (strcmp(key, "rng_version") == 0) inst->rng_version = clamp_int(atoi(val), 1, 2);
+    else if (strcmp(key, "parts") == 0) {
+        inst->part_count = clamp_int(atoi(val), 1, MAX_PARTS);
+        update_early_lead(inst);
+    }
+    else if (strcmp(key, "part") == 0) inst->part_edit = clamp_int(atoi(val), 1, MAX_PARTS) - 1;
+    else if (strcmp(key, "runtime_state") == 0) set_runtime_state_hex(inst, val);
+    else if (strcmp(key, "preset_lib") == 0) (void)preset_lib_map(val);
+    else if (strcmp(key, "playhead_shm") == 0) (void)playhead_map(inst, val);
+    else if (strcmp(key, "preset_load") == 0) (void)load_preset_index(inst, preset_find(preset_lib_get(), val));
+    else if (strcmp(key, "preset_slot") == 0) (void)load_preset_index(inst, atoi(val));
+    else if (strcmp(key, "song") == 0) set_song_list(inst, val);
+    else if (strcmp(key, "tap_lane") == 0) {
+        inst->tap_lane = strcmp(val, "off") == 0 ? 0 : clamp_int(atoi(val), 0, MAX_LANES);
+        tap_reset(inst);
+    }
+    else if (strcmp(key, "song_mode") == 0) {
+        inst->song_mode = strcmp(val, "on") == 0 ? 1 : 0;
+        song_restart(inst);
     }
-    else if (strcmp(key, "missing_note_seed") == 0) inst->missing_note_seed = clamp_int(atoi(val), 0, 65535);
-    else if (strcmp(key, "scale_mode") == 0) {
-        if (strcmp(val, "natural_minor") == 0) inst->scale_mode = SCALE_NATURAL_MINOR;
-        else if (strcmp(val, "harmonic_minor") == 0) inst->scale_mode = SCALE_HARMONIC_MINOR;
-        else if (strcmp(val, "melodic_minor") == 0) inst->scale_mode = SCALE_MELODIC_MINOR;
-        else if (strcmp(val, "dorian") == 0) inst->scale_mode = SCALE_DORIAN;
-        else if (strcmp(val, "phrygian") == 0) inst->scale_mode = SCALE_PHRYGIAN;
-        else if (strcmp(val, "lydian") == 0) inst->scale_mode = SCALE_LYDIAN;
-        else if (strcmp(val, "mixolydian") == 0) inst->scale_mode = SCALE_MIXOLYDIAN;
-        else if (strcmp(val, "locrian") == 0) inst->scale_mode = SCALE_LOCRIAN;
-        else if (strcmp(val, "pentatonic_major") == 0) inst->scale_mode = SCALE_PENTATONIC_MAJOR;
-        else if (strcmp(val, "pentatonic_minor") == 0) inst->scale_mode = SCALE_PENTATONIC_MINOR;
-        else if (strcmp(val, "blues") == 0) inst->scale_mode = SCALE_BLUES;
-        else if (strcmp(val, "whole_tone") == 0) inst->scale_mode = SCALE_WHOLE_TONE;
-        else if (strcmp(val, "chromatic") == 0) inst->scale_mode = SCALE_CHROMATIC;
-        else inst->scale_mode = SCALE_MAJOR;
-    }
-    else if (strcmp(key, "scale_rng") == 0) inst->scale_rng = clamp_int(atoi(val), 1, 24);
-    else if (strcmp(key, "root_note") == 0) inst->root_note = clamp_int(atoi(val), 0, 11);
-    else if (strcmp(key, "octave") == 0) inst->octave = clamp_int(atoi(val), -3, 3);
     else if (strcmp(key, "state") == 0) {
         char s[64];
         int i;
+        int p;
         int parsed;
+        int edit = inst->part_edit;
+        /* Unprefixed keys in a state are part 1. */
+        inst->part_edit = 0;
         if (json_get_string(val, "play_mode", s, sizeof(s))) eucalypso_set_param(inst, "play_mode", s);
         if (json_get_string(val, "retrigger_mode", s, sizeof(s))) eucalypso_set_param(inst, "retrigger_mode", s);
         if (json_get_string(val, "rate", s, sizeof(s))) eucalypso_set_param(inst, "rate", s);
         if (json_get_string(val, "sync", s, sizeof(s))) eucalypso_set_param(inst, "sync", s);
-        if (json_get_int(val, "bpm", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "bpm", s); }
+        if (json_get_int(val, "clock_loss_mult", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "clock_loss_mult", s); }
+        if (json_get_int(val, "trig_note", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "trig_note", s); }
+        if (json_get_string(val, "trig_chan", s, sizeof(s))) eucalypso_set_param(inst, "trig_chan", s);
+        if (json_get_string(val, "catchup", s, sizeof(s))) eucalypso_set_param(inst, "catchup", s);
+        if (json_get_int(val, "catchup_ms", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "catchup_ms", s); }
+        if (json_get_int(val, "early_ms", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "early_ms", s); }
+        if (json_get_int(val, "capture_ms", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "capture_ms", s); }
+        if (json_get_int(val, "bpm", &parsed)) {
+            /* Recalling a state jumps straight to its tempo. */
+            int ramp_beats = inst->ramp_beats;
+            inst->ramp_beats = 0;
+            snprintf(s, sizeof(s), "%d", parsed);
+            eucalypso_set_param(inst, "bpm", s);
+            inst->ramp_beats = ramp_beats;
+        }
+        if (json_get_int(val, "ramp_beats", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "ramp_beats", s); }
+        if (json_get_string(val, "ramp_curve", s, sizeof(s))) eucalypso_set_param(inst, "ramp_curve", s);
         if (json_get_int(val, "swing", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "swing", s); }
         if (json_get_int(val, "max_voices", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "max_voices", s); }
+        if (json_get_string(val, "chan_mode", s, sizeof(s))) eucalypso_set_param(inst, "chan_mode", s);
+        if (json_get_int(val, "chan_lo", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "chan_lo", s); }
+        if (json_get_int(val, "chan_hi", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "chan_hi", s); }
         if (json_get_int(val, "global_velocity", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "global_velocity", s); }
         if (json_get_int(val, "global_v_rnd", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "global_v_rnd", s); }
         if (json_get_int(val, "global_gate", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "global_gate", s); }
         if (json_get_int(val, "global_g_rnd", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "global_g_rnd", s); }
         if (json_get_int(val, "global_rnd_seed", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "global_rnd_seed", s); }
         if (json_get_int(val, "rand_cycle", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "rand_cycle", s); }
+        if (json_get_int(val, "evolve", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "evolve", s); }
+        if (json_get_int(val, "evolve_seed", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "evolve_seed", s); }
+        /* States saved before rng_version existed keep the original generator. */
+        if (json_get_int(val, "rng_version", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "rng_version", s); }
+        else inst->rng_version = 1;
         if (json_get_string(val, "register_mode", s, sizeof(s))) eucalypso_set_param(inst, "register_mode", s);
         if (json_get_string(val, "held_order", s, sizeof(s))) eucalypso_set_param(inst, "held_order", s);
         if (json_get_int(val, "held_order_seed", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "held_order_seed", s); }
@@ -1542,97 +4040,194 @@ static void eucalypso_set_param(void *instance, const char *key, const char *val
         if (json_get_int(val, "scale_rng", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "scale_rng", s); }
         if (json_get_int(val, "root_note", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "root_note", s); }
         if (json_get_int(val, "octave", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "octave", s); }
+        if (json_get_string(val, "part_chan", s, sizeof(s))) eucalypso_set_param(inst, "part_chan", s);
+        if (strstr(val, "\"song\"")) {
+            char song[SONG_LIST_MAX];
+            song[0] = '\0';
+            (void)json_get_string(val, "song", song, sizeof(song));
+            eucalypso_set_param(inst, "song", song);
+        }
+        if (json_get_string(val, "song_mode", s, sizeof(s))) eucalypso_set_param(inst, "song_mode", s);
         for (i = 0; i < MAX_LANES; i++) {
-            static const char *lane_fields[] = {
-                "enabled", "steps", "pulses", "rotation", "drop", "drop_seed",
-                "note", "n_rnd", "n_seed", "octave", "oct_rnd", "oct_seed",
-                "oct_rng", "velocity", "gate"
-            };
             int f;
-            for (f = 0; f < (int)(sizeof(lane_fields) / sizeof(lane_fields[0])); f++) {
+            for (f = 0; f < (int)(sizeof(k_lane_state_fields) / sizeof(k_lane_state_fields[0])); f++) {
+                char k[64];
+                snprintf(k, sizeof(k), "lane%d_%s", i + 1, k_lane_state_fields[f]);
+                if (json_get_field(val, k, k_lane_state_fields[f], s, sizeof(s))) eucalypso_set_param(inst, k, s);
+            }
+        }
+        for (p = 1; p < MAX_PARTS; p++) {
+            int f;
+            char prefix[24];
+            reset_part(&inst->parts[p], p);
+            snprintf(prefix, sizeof(prefix), "\"part%d_", p + 1);
+            if (!strstr(val, prefix)) continue;
+            for (f = 0; f < (int)(sizeof(k_part_state_keys) / sizeof(k_part_state_keys[0])); f++) {
                 char k[64];
-                snprintf(k, sizeof(k), "lane%d_%s", i + 1, lane_fields[f]);
-                if (strcmp(lane_fields[f], "enabled") == 0 || strcmp(lane_fields[f], "oct_rng") == 0) {
-                    if (json_get_string(val, k, s, sizeof(s))) eucalypso_set_param(inst, k, s);
-                } else if (json_get_int(val, k, &parsed)) {
-                    snprintf(s, sizeof(s), "%d", parsed);
-                    eucalypso_set_param(inst, k, s);
+                snprintf(k, sizeof(k), "part%d_%s", p + 1, k_part_state_keys[f]);
+                if (json_get_field(val, k, k_part_state_keys[f], s, sizeof(s))) eucalypso_set_param(inst, k, s);
+            }
+            for (i = 0; i < MAX_LANES; i++) {
+                for (f = 0; f < (int)(sizeof(k_lane_state_fields) / sizeof(k_lane_state_fields[0])); f++) {
+                    char k[64];
+                    snprintf(k, sizeof(k), "part%d_lane%d_%s", p + 1, i + 1, k_lane_state_fields[f]);
+                    if (json_get_field(val, k, k_lane_state_fields[f], s, sizeof(s))) eucalypso_set_param(inst, k, s);
                 }
             }
         }
+        /* States saved before parts existed hold a single part. */
+        if (json_get_int(val, "parts", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "parts", s); }
+        else eucalypso_set_param(inst, "parts", "1");
+        if (json_get_int(val, "part", &parsed)) { snprintf(s, sizeof(s), "%d", parsed); eucalypso_set_param(inst, "part", s); }
+        else inst->part_edit = edit;
     }
 }
 
 static int eucalypso_get_param(void *instance, const char *key, char *buf, int buf_len) {
     eucalypso_instance_t *inst = (eucalypso_instance_t *)instance;
+    const part_t *part;
+    int part_idx;
     int lane_idx;
     const char *suffix;
+    int prefixed;
     int pos = 0;
     int i;
     if (!inst || !key || !buf || buf_len < 1) return -1;
 
+    prefixed = parse_part_key(key, &part_idx, &suffix);
+    if (prefixed) key = suffix;
+    else part_idx = inst->part_edit;
+    part = &inst->parts[part_idx];
     if (parse_lane_key(key, &lane_idx, &suffix)) {
-        return get_lane_param(&inst->lanes[lane_idx], suffix, buf, buf_len);
+        return get_lane_param(&part->lanes[lane_idx], suffix, buf, buf_len);
     }
+    pos = get_part_param(part, key, buf, buf_len);
+    if (pos >= 0 || prefixed) return pos;
+    pos = 0;
 
     if (strcmp(key, "play_mode") == 0) return snprintf(buf, buf_len, "%s", play_mode_to_string(inst->play_mode));
     if (strcmp(key, "retrigger_mode") == 0) return snprintf(buf, buf_len, "%s", retrigger_to_string(inst->retrigger_mode));
     if (strcmp(key, "rate") == 0) return snprintf(buf, buf_len, "%s", rate_to_string(inst->rate));
     if (strcmp(key, "sync") == 0) return snprintf(buf, buf_len, "%s", sync_to_string(inst->sync_mode));
     if (strcmp(key, "error") == 0) return eucalypso_get_sync_warning(inst, buf, buf_len);
+    if (strcmp(key, "clock_loss_mult") == 0) return snprintf(buf, buf_len, "%d", inst->clock_loss_mult);
+    if (strcmp(key, "trig_note") == 0) return snprintf(buf, buf_len, "%d", inst->trig_note);
+    if (strcmp(key, "trig_chan") == 0) {
+        if (inst->trig_chan == 0) return snprintf(buf, buf_len, "any");
+        return snprintf(buf, buf_len, "%d", inst->trig_chan);
+    }
+    if (strcmp(key, "catchup") == 0) return snprintf(buf, buf_len, "%s", catchup_to_string(inst->catchup_policy));
+    if (strcmp(key, "catchup_ms") == 0) return snprintf(buf, buf_len, "%d", inst->catchup_ms);
+    if (strcmp(key, "early_ms") == 0) return snprintf(buf, buf_len, "%d", inst->early_ms);
+    if (strcmp(key, "capture_ms") == 0) return snprintf(buf, buf_len, "%d", inst->capture_ms);
+    if (strcmp(key, "backlog_depth") == 0) return snprintf(buf, buf_len, "%d", inst->backlog_depth_peak);
+    if (strcmp(key, "backlog_skipped") == 0) return snprintf(buf, buf_len, "%llu", (unsigned long long)inst->backlog_skipped);
     if (strcmp(key, "bpm") == 0) return snprintf(buf, buf_len, "%d", inst->bpm);
+    if (strcmp(key, "bpm_now") == 0) return snprintf(buf, buf_len, "%.2f", current_tempo(inst));
+    if (strcmp(key, "ramp_beats") == 0) return snprintf(buf, buf_len, "%d", inst->ramp_beats);
+    if (strcmp(key, "ramp_curve") == 0) return snprintf(buf, buf_len, "%s", ramp_curve_to_string(inst->ramp_curve));
     if (strcmp(key, "swing") == 0) return snprintf(buf, buf_len, "%d", inst->swing);
     if (strcmp(key, "max_voices") == 0) return snprintf(buf, buf_len, "%d", inst->max_voices);
+    if (strcmp(key, "chan_mode") == 0) return snprintf(buf, buf_len, "%s", chan_mode_to_string(inst->chan_mode));
+    if (strcmp(key, "chan_lo") == 0) return snprintf(buf, buf_len, "%d", inst->chan_lo);
+    if (strcmp(key, "chan_hi") == 0) return snprintf(buf, buf_len, "%d", inst->chan_hi);
     if (strcmp(key, "global_velocity") == 0) return snprintf(buf, buf_len, "%d", inst->global_velocity);
     if (strcmp(key, "global_v_rnd") == 0) return snprintf(buf, buf_len, "%d", inst->global_v_rnd);
     if (strcmp(key, "global_gate") == 0) return snprintf(buf, buf_len, "%d", inst->global_gate);
     if (strcmp(key, "global_g_rnd") == 0) return snprintf(buf, buf_len, "%d", inst->global_g_rnd);
     if (strcmp(key, "global_rnd_seed") == 0) return snprintf(buf, buf_len, "%d", inst->global_rnd_seed);
     if (strcmp(key, "rand_cycle") == 0) return snprintf(buf, buf_len, "%d", inst->rand_cycle);
-    if (strcmp(key, "register_mode") == 0) return snprintf(buf, buf_len, "%s", register_mode_to_string(inst->register_mode));
-    if (strcmp(key, "held_order") == 0) return snprintf(buf, buf_len, "%s", held_order_to_string(inst->held_order));
-    if (strcmp(key, "held_order_seed") == 0) return snprintf(buf, buf_len, "%d", inst->held_order_seed);
-    if (strcmp(key, "missing_note_policy") == 0) return snprintf(buf, buf_len, "%s", missing_note_policy_to_string(inst->missing_note_policy));
-    if (strcmp(key, "missing_note_seed") == 0) return snprintf(buf, buf_len, "%d", inst->missing_note_seed);
-    if (strcmp(key, "scale_mode") == 0) return snprintf(buf, buf_len, "%s", scale_mode_to_string(inst->scale_mode));
-    if (strcmp(key, "scale_rng") == 0) return snprintf(buf, buf_len, "%d", inst->scale_rng);
-    if (strcmp(key, "root_note") == 0) return snprintf(buf, buf_len, "%d", inst->root_note);
-    if (strcmp(key, "octave") == 0) return snprintf(buf, buf_len, "%d", inst->octave);
+    if (strcmp(key, "evolve") == 0) return snprintf(buf, buf_len, "%d", inst->evolve);
+    if (strcmp(key, "evolve_seed") == 0) return snprintf(buf, buf_len, "%d", inst->evolve_seed);
+    if (strcmp(key, "rng_version") == 0) return snprintf(buf, buf_len, "%d", inst->rng_version);
+    if (strcmp(key, "parts") == 0) return snprintf(buf, buf_len, "%d", inst->part_count);
+    if (strcmp(key, "part") == 0) return snprintf(buf, buf_len, "%d", inst->part_edit + 1);
     if (strcmp(key, "name") == 0) return snprintf(buf, buf_len, "Eucalypso");
     if (strcmp(key, "bank_name") == 0) return snprintf(buf, buf_len, "Factory");
+    if (strcmp(key, "runtime_state") == 0) return get_runtime_state_hex(inst, buf, buf_len);
+    if (strcmp(key, "playhead_shm") == 0) return snprintf(buf, buf_len, "%s", inst->playhead_name);
+    if (strcmp(key, "preset_lib") == 0) {
+        const preset_lib_t *lib = preset_lib_get();
+        return snprintf(buf, buf_len, "%s", lib ? lib->path : "");
+    }
+    if (strcmp(key, "preset_count") == 0) {
+        const preset_lib_t *lib = preset_lib_get();
+        return snprintf(buf, buf_len, "%u", lib ? (unsigned)lib->count : 0u);
+    }
+    if (strcmp(key, "preset_load") == 0) return snprintf(buf, buf_len, "%s", inst->preset_name);
+    if (strcmp(key, "preset_block") == 0) return get_param_block_hex(inst, buf, buf_len);
+    if (strcmp(key, "song") == 0) return format_song_list(inst, buf, buf_len);
+    if (strcmp(key, "tap_lane") == 0) {
+        if (inst->tap_lane <= 0) return snprintf(buf, buf_len, "off");
+        return snprintf(buf, buf_len, "%d", inst->tap_lane);
+    }
+    if (strcmp(key, "tap_fit") == 0) {
+        if (inst->tap_fit_steps <= 0) return snprintf(buf, buf_len, "%s", "");
+        return snprintf(buf, buf_len, "%d:%d:%d:%d", inst->tap_fit_steps, inst->tap_fit_pulses,
+                        inst->tap_fit_rotation, inst->tap_fit_distance);
+    }
+    if (strcmp(key, "song_mode") == 0) return snprintf(buf, buf_len, "%s", inst->song_mode ? "on" : "off");
+    if (strcmp(key, "song_pos") == 0) return snprintf(buf, buf_len, "%d", inst->song_entry < 0 ? 0 : inst->song_entry);
+    if (sscanf(key, "preset_name_%d", &i) == 1) {
+        const uint8_t *entry = preset_entry(preset_lib_get(), i);
+        return entry ? snprintf(buf, buf_len, "%s", (const char *)entry) : -1;
+    }
+    if (sscanf(key, "preset_tags_%d", &i) == 1) {
+        const uint8_t *entry = preset_entry(preset_lib_get(), i);
+        return entry ? snprintf(buf, buf_len, "%s", (const char *)entry + PRESET_NAME_LEN) : -1;
+    }
     if (strcmp(key, "chain_params") == 0) {
         if (inst->chain_params_len > 0) return snprintf(buf, buf_len, "%s", inst->chain_params_json);
         return -1;
     }
 
     if (strcmp(key, "state") == 0) {
+        const part_t *part1 = &inst->parts[0];
+        char trig_chan[8];
+        char part1_chan[8];
+        if (inst->trig_chan == 0) snprintf(trig_chan, sizeof(trig_chan), "any");
+        else snprintf(trig_chan, sizeof(trig_chan), "%d", inst->trig_chan);
+        (void)get_part_param(part1, "part_chan", part1_chan, (int)sizeof(part1_chan));
         if (!appendf(buf, buf_len, &pos, "{")) return -1;
         if (!appendf(buf, buf_len, &pos,
                      "\"play_mode\":\"%s\",\"retrigger_mode\":\"%s\",\"rate\":\"%s\",\"sync\":\"%s\","
-                     "\"bpm\":%d,\"swing\":%d,\"max_voices\":%d,"
+                     "\"clock_loss_mult\":%d,\"trig_note\":%d,\"trig_chan\":\"%s\",\"catchup\":\"%s\",\"catchup_ms\":%d,\"early_ms\":%d,\"capture_ms\":%d,\"bpm\":%d,\"ramp_beats\":%d,\"ramp_curve\":\"%s\",\"swing\":%d,\"max_voices\":%d,\"chan_mode\":\"%s\",\"chan_lo\":%d,\"chan_hi\":%d,"
                      "\"global_velocity\":%d,\"global_v_rnd\":%d,\"global_gate\":%d,\"global_g_rnd\":%d,"
-                     "\"global_rnd_seed\":%d,\"rand_cycle\":%d,"
+                     "\"global_rnd_seed\":%d,\"rand_cycle\":%d,\"evolve\":%d,\"evolve_seed\":%d,\"rng_version\":%d,\"parts\":%d,\"part\":%d,"
                      "\"register_mode\":\"%s\",\"held_order\":\"%s\",\"held_order_seed\":%d,"
                      "\"missing_note_policy\":\"%s\",\"missing_note_seed\":%d,"
-                     "\"scale_mode\":\"%s\",\"scale_rng\":%d,\"root_note\":%d,\"octave\":%d",
+                     "\"scale_mode\":\"%s\",\"scale_rng\":%d,\"root_note\":%d,\"octave\":%d,\"part_chan\":\"%s\","
+                     "\"song_mode\":\"%s\",\"song\":\"",
                      play_mode_to_string(inst->play_mode),
                      retrigger_to_string(inst->retrigger_mode),
                      rate_to_string(inst->rate),
                      sync_to_string(inst->sync_mode),
-                     inst->bpm, inst->swing, inst->max_voices,
+                     inst->clock_loss_mult, inst->trig_note, trig_chan,
+                     catchup_to_string(inst->catchup_policy), inst->catchup_ms, inst->early_ms, inst->capture_ms, inst->bpm,
+                     inst->ramp_beats, ramp_curve_to_string(inst->ramp_curve), inst->swing, inst->max_voices,
+                     chan_mode_to_string(inst->chan_mode), inst->chan_lo, inst->chan_hi,
                      inst->global_velocity, inst->global_v_rnd, inst->global_gate, inst->global_g_rnd,
-                     inst->global_rnd_seed, inst->rand_cycle,
-                     register_mode_to_string(inst->register_mode),
-                     held_order_to_string(inst->held_order),
-                     inst->held_order_seed,
-                     missing_note_policy_to_string(inst->missing_note_policy),
-                     inst->missing_note_seed,
-                     scale_mode_to_string(inst->scale_mode),
-                     inst->scale_rng, inst->root_note, inst->octave)) {
+                     inst->global_rnd_seed, inst->rand_cycle, inst->evolve, inst->evolve_seed, inst->rng_version,
+                     inst->part_count, inst->part_edit + 1,
+                     register_mode_to_string(part1->register_mode),
+                     held_order_to_string(part1->held_order),
+                     part1->held_order_seed,
+                     missing_note_policy_to_string(part1->missing_note_policy),
+                     part1->missing_note_seed,
+                     scale_mode_to_string(part1->scale_mode),
+                     part1->scale_rng, part1->root_note, part1->octave, part1_chan,
+                     inst->song_mode ? "on" : "off")) {
             return -1;
         }
+        if (pos >= buf_len) return -1;
+        {
+            int wrote = format_song_list(inst, buf + pos, buf_len - pos);
+            if (wrote < 0) return -1;
+            pos += wrote;
+        }
+        if (!appendf(buf, buf_len, &pos, "\"")) return -1;
         for (i = 0; i < MAX_LANES; i++) {
-            lane_t *lane = &inst->lanes[i];
+            const lane_t *lane = &part1->lanes[i];
             const char *oct_rng_names[] = { "+1", "-1", "+-1", "+2", "-2", "+-2" };
             int oct_rng = clamp_int(lane->oct_rng, 0, 5);
             if (!appendf(buf, buf_len, &pos,
@@ -1640,7 +4235,8 @@ static int eucalypso_get_param(void *instance, const char *key, char *buf, int b
                          "\"lane%d_drop\":%d,\"lane%d_drop_seed\":%d,\"lane%d_note\":%d,"
                          "\"lane%d_n_rnd\":%d,\"lane%d_n_seed\":%d,"
                          "\"lane%d_octave\":%d,\"lane%d_oct_rnd\":%d,\"lane%d_oct_seed\":%d,"
-                         "\"lane%d_oct_rng\":\"%s\",\"lane%d_velocity\":%d,\"lane%d_gate\":%d",
+                         "\"lane%d_oct_rng\":\"%s\",\"lane%d_velocity\":%d,\"lane%d_gate\":%d,"
+                         "\"lane%d_early_ms\":%d,\"lane%d_dir\":\"%s\",\"lane%d_dir_seed\":%d,\"lane%d_legato\":\"%s\"",
                          i + 1, lane->enabled ? "on" : "off",
                          i + 1, lane->steps,
                          i + 1, lane->pulses,
@@ -1655,10 +4251,17 @@ static int eucalypso_get_param(void *instance, const char *key, char *buf, int b
                          i + 1, lane->oct_seed,
                          i + 1, oct_rng_names[oct_rng],
                          i + 1, lane->velocity,
-                         i + 1, lane->gate)) {
+                         i + 1, lane->gate,
+                         i + 1, lane->early_ms,
+                         i + 1, direction_to_string(lane->direction),
+                         i + 1, lane->dir_seed,
+                         i + 1, lane->legato ? "on" : "off")) {
                 return -1;
             }
         }
+        for (i = 1; i < inst->part_count; i++) {
+            if (!append_part_state(&inst->parts[i], i, buf, buf_len, &pos)) return -1;
+        }
         if (!appendf(buf, buf_len, &pos, "}")) return -1;
         return pos;
     }
@@ -1687,12 +4290,16 @@ static int eucalypso_process_midi(void *instance, const uint8_t *in_msg, int in_
             inst->clock_counter = 0;
             inst->clock_tick_total = 0;
             inst->pending_step_triggers = 1;
+            clear_pending_notes(inst);
             inst->anchor_step = 0;
             inst->phrase_anchor_step = 0;
             inst->phrase_restart_pending = (inst->retrigger_mode == RETRIG_RESTART) ? 1 : 0;
             inst->preview_step_pending = 0;
             inst->preview_step_id = 0;
             inst->swing_phase = 0;
+            clock_watchdog_reset(inst);
+            reset_backlog_stats(inst);
+            song_rewind(inst);
             dlog(inst, "MIDI Start cc=%d pending=%d anchor=%llu",
                  inst->clock_counter, inst->pending_step_triggers, (unsigned long long)inst->anchor_step);
             return 0;
@@ -1725,15 +4332,17 @@ static int eucalypso_process_midi(void *instance, const uint8_t *in_msg, int in_
             inst->suppress_initial_note_restart = 1;
             inst->clock_start_grace_armed = 0;
             inst->internal_start_grace_armed = 0;
-            inst->internal_sample_total = 0;
-            inst->samples_until_step_f = 0.0;
-            inst->samples_until_step = 0;
+            inst->internal_flicks = 0;
+            inst->flicks_until_step = 0.0;
+            clear_pending_notes(inst);
             inst->anchor_step = 0;
             inst->phrase_anchor_step = 0;
             inst->phrase_restart_pending = (inst->retrigger_mode == RETRIG_RESTART) ? 1 : 0;
             inst->preview_step_pending = 0;
             inst->preview_step_id = 0;
             inst->swing_phase = 0;
+            reset_backlog_stats(inst);
+            song_rewind(inst);
             dlog(inst, "%s anchor=%llu", status == 0xFA ? "MIDI Start (internal)" : "MIDI Continue (internal)",
                  (unsigned long long)inst->anchor_step);
             return 0;
@@ -1748,25 +4357,30 @@ static int eucalypso_process_midi(void *instance, const uint8_t *in_msg, int in_
         uint8_t note = in_msg[1];
         uint8_t vel = in_msg[2];
         int live_before = inst->active_count;
+        if (is_trigger_note(inst, in_msg)) {
+            if (type == 0x90 && vel > 0) return process_trigger_note(inst, out_msgs, out_lens, max_out);
+            return 0;
+        }
+        if (type == 0x90 && vel > 0 && inst->tap_lane > 0) {
+            tap_note_on(inst);
+            return 0;
+        }
+        if (inst->capture_ms > 0) {
+            capture_note_event(inst, note, type == 0x90 && vel > 0);
+            return 0;
+        }
         if (type == 0x90 && vel > 0) {
             dlog(inst, "NOTE_ON note=%u vel=%u cc=%d pending=%d active_before=%d anchor=%llu",
                  note, vel, inst->clock_counter, inst->pending_step_triggers, live_before,
                  (unsigned long long)inst->anchor_step);
             note_on(inst, note);
-            if (live_before == 0 && inst->active_count > 0) {
-                inst->suppress_initial_note_restart = 0;
-                if (inst->retrigger_mode == RETRIG_RESTART) {
-                    inst->phrase_restart_pending = 1;
-                    dlog(inst, "phrase restart armed anchor=%llu",
-                         (unsigned long long)inst->anchor_step);
-                }
-            }
         } else {
             dlog(inst, "NOTE_OFF note=%u cc=%d pending=%d active=%d anchor=%llu",
                  note, inst->clock_counter, inst->pending_step_triggers, inst->active_count,
                  (unsigned long long)inst->anchor_step);
             note_off(inst, note);
         }
+        settle_register(inst, live_before);
         return 0;
     }
 
@@ -1783,35 +4397,79 @@ static int eucalypso_tick(void *instance, int frames, int sample_rate,
                           uint8_t out_msgs[][3], int out_lens[], int max_out) {
     eucalypso_instance_t *inst = (eucalypso_instance_t *)instance;
     int count = 0;
+    int depth = 0;
+    uint64_t elapsed;
+    double quantum;
     if (!inst || frames < 0 || max_out < 1) return 0;
 
     if (inst->timing_dirty || inst->sample_rate != sample_rate) {
         recalc_internal_timing(inst, sample_rate);
     }
+    elapsed = frames_to_flicks(inst, frames, sample_rate);
+    inst->flick_clock += elapsed;
+    quantum = (double)elapsed;
+    if (inst->last_tick_flicks > 0 && inst->last_tick_flicks < elapsed) quantum = (double)inst->last_tick_flicks;
+    inst->last_tick_flicks = elapsed;
+    update_early_lead(inst);
+    capture_poll(inst);
+    playhead_poll(inst);
 
     if (inst->sync_mode == SYNC_INTERNAL) {
-        (void)advance_voice_timers_samples(inst, frames, out_msgs, out_lens, max_out, &count);
+        double lead = inst->early_lead_flicks;
+        (void)advance_voice_timers_flicks(inst, elapsed, out_msgs, out_lens, max_out, &count);
+        (void)emit_pending_notes(inst, out_msgs, out_lens, max_out, &count);
         if (count >= max_out) return count;
         if (!inst->clock_running) return count;
 
-        inst->internal_sample_total += (uint64_t)frames;
-        inst->samples_until_step_f -= (double)frames;
-        while (inst->samples_until_step_f <= 0.0 && count < max_out) {
-            count += run_anchor_step(inst, out_msgs + count, out_lens + count, max_out - count);
-            inst->samples_until_step_f += next_internal_interval(inst);
-            if (inst->samples_until_step_f < 1.0) inst->samples_until_step_f = 1.0;
+        /* Steps are evaluated lead flicks before they are due. */
+        inst->internal_flicks += elapsed;
+        inst->flicks_until_step -= (double)elapsed;
+        while (inst->flicks_until_step <= lead && count < max_out) {
+            double age = lead - inst->flicks_until_step;
+            double next = next_internal_interval(inst);
+            int is_latest = (inst->flicks_until_step + next) > lead;
+            depth++;
+            if (catchup_should_play(inst, is_latest, age, quantum)) {
+                count += run_anchor_step(inst, out_msgs + count, out_lens + count, max_out - count);
+            } else {
+                skip_anchor_step(inst);
+            }
+            if (inst->song_retimed) {
+                inst->song_retimed = 0;
+                next = next_internal_interval(inst);
+            }
+            inst->flicks_until_step += next;
         }
-        inst->samples_until_step = (int)(inst->samples_until_step_f + 0.5);
-        if (inst->samples_until_step < 1) inst->samples_until_step = 1;
+        if (depth > 0) note_backlog_depth(inst, depth);
+        return count;
+    }
+
+    if (inst->sync_mode == SYNC_NOTE) {
+        (void)advance_voice_timers_flicks(inst, elapsed, out_msgs, out_lens, max_out, &count);
         return count;
     }
 
+    (void)clock_watchdog_check(inst, elapsed, out_msgs, out_lens, max_out, &count);
+    (void)emit_pending_notes(inst, out_msgs, out_lens, max_out, &count);
+    if (count >= max_out) return count;
+
     if (inst->pending_step_triggers > 0) {
+        uint64_t cps = (uint64_t)(inst->clocks_per_step > 0 ? inst->clocks_per_step : 1);
+        uint64_t newest_boundary = (inst->clock_tick_total / cps) * cps;
         dlog(inst, "tick drain start pending=%d anchor=%llu", inst->pending_step_triggers,
              (unsigned long long)inst->anchor_step);
+        note_backlog_depth(inst, inst->pending_step_triggers);
         while (inst->pending_step_triggers > 0 && count < max_out) {
-            count += run_anchor_step(inst, out_msgs + count, out_lens + count, max_out - count);
+            uint64_t behind = (uint64_t)(inst->pending_step_triggers - 1) * cps;
+            uint64_t boundary = newest_boundary >= behind ? newest_boundary - behind : 0;
+            double age = (double)(inst->clock_tick_total - boundary) * inst->clock_interval_f;
+            if (catchup_should_play(inst, inst->pending_step_triggers == 1, age, quantum)) {
+                count += run_anchor_step(inst, out_msgs + count, out_lens + count, max_out - count);
+            } else {
+                skip_anchor_step(inst);
+            }
             inst->pending_step_triggers--;
+            inst->song_retimed = 0;
             dlog(inst, "tick drain step done pending=%d out=%d anchor=%llu",
                  inst->pending_step_triggers, count, (unsigned long long)inst->anchor_step);
         }
@@ -1831,5 +4489,6 @@ static midi_fx_api_v1_t g_api = {
 
 midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host) {
     g_host = host;
+    build_euclid_masks();
     return &g_api;
 }
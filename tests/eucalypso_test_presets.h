@@ -0,0 +1,71 @@
+/*
+ * Shared preset library fixture for the Eucalypso tests.
+ *
+ * Libraries are built with the real packer (tools/eucalypso_pack_presets.c,
+ * built by scripts/build-pack-presets.sh), so the tests follow its on-disk
+ * format instead of restating it. Each preset is a state JSON as returned by
+ * get_param("state"); it is written to <dir>/<name>.json with an optional
+ * "tags" key and handed to the packer, which names presets after the file.
+ */
+#ifndef EUCALYPSO_TEST_PRESETS_H
+#define EUCALYPSO_TEST_PRESETS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_PRESETS_MAX 8
+
+typedef struct {
+    const char *name;
+    const char *tags;
+    const char *state;
+} test_preset_t;
+
+typedef struct {
+    char dir[64];
+    char path[96];
+    int count;
+    char files[TEST_PRESETS_MAX][128];
+} test_library_t;
+
+/* Packs presets into lib->path inside a fresh temp directory; returns 0 on
+ * any failure. */
+static int test_library_pack(test_library_t *lib, const char *packer, const test_preset_t *presets, int count) {
+    char cmd[2048];
+    size_t pos;
+    int i;
+    memset(lib, 0, sizeof(*lib));
+    if (count < 1 || count > TEST_PRESETS_MAX) return 0;
+    strcpy(lib->dir, "/tmp/eucalypso_presets_XXXXXX");
+    if (!mkdtemp(lib->dir)) return 0;
+    snprintf(lib->path, sizeof(lib->path), "%s/presets.eupl", lib->dir);
+    pos = (size_t)snprintf(cmd, sizeof(cmd), "'%s' -o '%s'", packer, lib->path);
+    for (i = 0; i < count; i++) {
+        FILE *f;
+        snprintf(lib->files[i], sizeof(lib->files[i]), "%s/%s.json", lib->dir, presets[i].name);
+        lib->count = i + 1;
+        f = fopen(lib->files[i], "w");
+        if (!f || presets[i].state[0] != '{') {
+            if (f) fclose(f);
+            return 0;
+        }
+        if (presets[i].tags) fprintf(f, "{\"tags\":\"%s\",%s", presets[i].tags, presets[i].state + 1);
+        else fputs(presets[i].state, f);
+        if (fclose(f) != 0) return 0;
+        pos += (size_t)snprintf(cmd + pos, sizeof(cmd) - pos, " '%s'", lib->files[i]);
+        if (pos + sizeof(" >/dev/null") > sizeof(cmd)) return 0;
+    }
+    strncat(cmd, " >/dev/null", sizeof(cmd) - strlen(cmd) - 1);
+    return system(cmd) == 0;
+}
+
+static void test_library_remove(test_library_t *lib) {
+    int i;
+    for (i = 0; i < lib->count; i++) unlink(lib->files[i]);
+    unlink(lib->path);
+    if (lib->dir[0]) rmdir(lib->dir);
+}
+
+#endif
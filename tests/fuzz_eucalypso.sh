@@ -0,0 +1,26 @@
+#!/usr/bin/env bash
+# Build and run the libFuzzer targets.
+# Usage: tests/fuzz_eucalypso.sh [set_param|midi] [libFuzzer args...]
+# Requires clang with libFuzzer. Per-call cycle budget: EUCALYPSO_FUZZ_BUDGET_CYCLES.
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+MOVE_ANYTHING_SRC="${MOVE_ANYTHING_SRC:-$ROOT_DIR/../move-anything/src}"
+TARGET="${1:-midi}"
+shift || true
+BIN="$ROOT_DIR/build/fuzz/fuzz_eucalypso_$TARGET"
+CORPUS="$ROOT_DIR/build/fuzz/corpus_$TARGET"
+
+mkdir -p "$(dirname "$BIN")" "$CORPUS"
+
+clang -std=c11 -Wall -Wextra -Werror -O1 -g \
+  -fsanitize=fuzzer,address,undefined \
+  -DEUCALYPSO_DEBUG_LOG=0 \
+  -I"$MOVE_ANYTHING_SRC" \
+  -I"$ROOT_DIR/src" \
+  "$ROOT_DIR/tests/fuzz_eucalypso_$TARGET.c" \
+  "$ROOT_DIR/src/dsp/eucalypso.c" \
+  -o "$BIN" \
+  -lm
+
+"$BIN" "$CORPUS" "$@"
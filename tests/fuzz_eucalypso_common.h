@@ -0,0 +1,114 @@
+/*
+ * Shared helpers for the Eucalypso libFuzzer targets.
+ *
+ * Every entry-point call is timed against a cycle budget so inputs that make
+ * the engine loop (for example a long phase realign) are reported as
+ * failures, not only crashes. Override the budget with
+ * EUCALYPSO_FUZZ_BUDGET_CYCLES.
+ *
+ * Building with -DFUZZ_STANDALONE adds a main() that replays input files,
+ * for reproducing findings without libFuzzer.
+ */
+#ifndef FUZZ_EUCALYPSO_COMMON_H
+#define FUZZ_EUCALYPSO_COMMON_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define FUZZ_DEFAULT_BUDGET_CYCLES 5000000ULL
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+static uint64_t g_fuzz_budget = FUZZ_DEFAULT_BUDGET_CYCLES;
+static midi_fx_api_v1_t *g_fuzz_api = NULL;
+
+static int fuzz_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_RUNNING;
+}
+
+static inline uint64_t fuzz_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return (uint64_t)__rdtsc();
+#elif defined(__aarch64__)
+    uint64_t v;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static void fuzz_check_budget(uint64_t start, const char *what) {
+    uint64_t spent = fuzz_cycles() - start;
+    if (spent > g_fuzz_budget) {
+        fprintf(stderr, "PERF: %s took %llu cycles (budget %llu)\n", what,
+                (unsigned long long)spent, (unsigned long long)g_fuzz_budget);
+        abort();
+    }
+}
+
+static midi_fx_api_v1_t *fuzz_api(void) {
+    static host_api_v1_t host;
+    if (!g_fuzz_api) {
+        const char *env = getenv("EUCALYPSO_FUZZ_BUDGET_CYCLES");
+        if (env && env[0]) g_fuzz_budget = strtoull(env, NULL, 10);
+        memset(&host, 0, sizeof(host));
+        host.api_version = MOVE_PLUGIN_API_VERSION;
+        host.get_clock_status = fuzz_get_clock_status;
+        g_fuzz_api = move_midi_fx_init(&host);
+        if (!g_fuzz_api) abort();
+    }
+    return g_fuzz_api;
+}
+
+#define FUZZ_TIMED(what, call) \
+    do { \
+        uint64_t fuzz_t0_ = fuzz_cycles(); \
+        call; \
+        fuzz_check_budget(fuzz_t0_, what); \
+    } while (0)
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+#ifdef FUZZ_STANDALONE
+int main(int argc, char **argv) {
+    int i;
+    for (i = 1; i < argc; i++) {
+        FILE *f = fopen(argv[i], "rb");
+        uint8_t *buf;
+        long len;
+        if (!f) {
+            perror(argv[i]);
+            return 1;
+        }
+        fseek(f, 0, SEEK_END);
+        len = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        buf = (uint8_t *)malloc(len > 0 ? (size_t)len : 1);
+        if (!buf || (len > 0 && fread(buf, 1, (size_t)len, f) != (size_t)len)) {
+            fclose(f);
+            free(buf);
+            return 1;
+        }
+        fclose(f);
+        LLVMFuzzerTestOneInput(buf, (size_t)len);
+        free(buf);
+        printf("ran %s (%ld bytes)\n", argv[i], len);
+    }
+    return 0;
+}
+#endif
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ * libFuzzer target: eucalypso process_midi/tick byte streams.
+ *
+ * The first byte picks the sync mode. After that each byte is an opcode:
+ * - 0x80-0xFF: a MIDI status, followed by its data bytes from the input
+ * - 0x00-0x3F: tick for ((op + 1) * 32) frames
+ * - 0x40-0x4F: tick for a long host stall (op - 0x3F seconds of frames)
+ * - 0x50-0x5F: change bpm (runs the internal phase realign)
+ * - 0x60-0x6F: change rate
+ * - 0x70-0x7F: change a lane's steps/pulses from the next byte
+ */
+#include "fuzz_eucalypso_common.h"
+
+static int midi_data_len(uint8_t status) {
+    uint8_t type = status & 0xF0;
+    if (status >= 0xF8) return 0;
+    if (status == 0xF1 || status == 0xF3) return 1;
+    if (status == 0xF2) return 2;
+    if (status >= 0xF0) return 0;
+    if (type == 0xC0 || type == 0xD0) return 1;
+    return 2;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static const char *rates[] = { "1/32", "1/16T", "1/16", "1/8T", "1/8", "1/4T", "1/4", "1/2", "1" };
+    static const int sample_rates[] = { 44100, 48000, 22050, 96000 };
+    midi_fx_api_v1_t *api = fuzz_api();
+    void *inst;
+    uint8_t out_msgs[128][3];
+    int out_lens[128];
+    char val[16];
+    int sample_rate;
+    size_t pos = 1;
+
+    if (size < 1) return 0;
+    inst = api->create_instance(".", NULL);
+    if (!inst) return 0;
+
+    api->set_param(inst, "sync", (data[0] & 1) ? "clock" : "internal");
+    api->set_param(inst, "lane2_enabled", "on");
+    api->set_param(inst, "lane3_enabled", "on");
+    api->set_param(inst, "lane4_enabled", "on");
+    api->set_param(inst, "max_voices", "64");
+    api->set_param(inst, "global_gate", (data[0] & 2) ? "1600" : "100");
+    sample_rate = sample_rates[(data[0] >> 2) & 3];
+
+    while (pos < size) {
+        uint8_t op = data[pos++];
+        if (op >= 0x80) {
+            uint8_t msg[3] = { op, 0, 0 };
+            int n = midi_data_len(op);
+            int i;
+            for (i = 0; i < n && pos < size; i++) msg[1 + i] = data[pos++] & 0x7F;
+            FUZZ_TIMED("process_midi",
+                       (void)api->process_midi(inst, msg, 1 + n, out_msgs, out_lens, 128));
+        } else if (op < 0x40) {
+            FUZZ_TIMED("tick", (void)api->tick(inst, (op + 1) * 32, sample_rate, out_msgs, out_lens, 128));
+        } else if (op < 0x50) {
+            FUZZ_TIMED("tick(stall)",
+                       (void)api->tick(inst, (op - 0x3F) * sample_rate, sample_rate, out_msgs, out_lens, 128));
+        } else if (op < 0x60) {
+            snprintf(val, sizeof(val), "%d", 40 + (op - 0x50) * 13);
+            FUZZ_TIMED("set_param(bpm)", api->set_param(inst, "bpm", val));
+        } else if (op < 0x70) {
+            FUZZ_TIMED("set_param(rate)", api->set_param(inst, "rate", rates[(op - 0x60) % 9]));
+        } else if (pos < size) {
+            char key[32];
+            uint8_t arg = data[pos++];
+            snprintf(key, sizeof(key), "lane%d_%s", ((op >> 1) & 3) + 1, (op & 1) ? "pulses" : "steps");
+            snprintf(val, sizeof(val), "%d", arg & 0x7F);
+            FUZZ_TIMED("set_param(lane)", api->set_param(inst, key, val));
+        }
+    }
+
+    api->destroy_instance(inst);
+    return 0;
+}
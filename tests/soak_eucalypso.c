@@ -0,0 +1,275 @@
+/*
+ * Long-duration soak and drift test for Eucalypso.
+ *
+ * Runs a single one-step lane offline for a simulated span (24 hours by
+ * default) in both sync modes across several tempos, rates, sample rates and
+ * swing amounts. For every configuration it checks:
+ *
+ *   - each step lands in the block that contains its ideal time, where the
+ *     ideal is the exact rational k * 60 * sr / (bpm * notes_per_beat) plus
+ *     the swing offset on odd steps, so any cumulative drift shows up;
+ *   - the number of steps matches the exact expected count;
+ *   - every note-off follows its note-on by the gate length (within a
+ *     block) and no voice is still sounding past its gate;
+ *   - per-tick cost does not grow: the mean cost of the last simulated hour
+ *     is compared with the first. Configurations without swing also re-set
+ *     the tempo once per hour, which re-derives the phase from the running
+ *     total, and must not move the grid.
+ *
+ * Usage: soak_eucalypso [hours]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+#define MAX_OUT 64
+#define GATE_PCT 50
+#define COST_GROWTH_LIMIT 4.0
+
+typedef struct {
+    int clock_sync;
+    int bpm;
+    const char *rate;
+    int npb_num;
+    int npb_den;
+    int sample_rate;
+    int block;
+    int swing;
+} soak_config_t;
+
+typedef struct {
+    uint64_t steps;
+    uint64_t gates;
+    double err_min;
+    double err_max;
+    double gate_err_max;
+    int64_t note_on_at;
+    int note_open;
+    int failed;
+} soak_result_t;
+
+static const soak_config_t k_configs[] = {
+    { 0, 120, "1/16", 4, 1, 44100, 128, 0 },
+    { 0, 97, "1/16", 4, 1, 48000, 128, 33 },
+    { 0, 240, "1/32", 8, 1, 48000, 64, 66 },
+    { 0, 60, "1/8T", 3, 1, 44100, 100, 0 },
+    { 0, 173, "1/16T", 6, 1, 96000, 256, 50 },
+    { 0, 133, "1/4T", 3, 2, 22050, 128, 0 },
+    { 1, 120, "1/16", 4, 1, 44100, 128, 0 },
+    { 1, 97, "1/16", 4, 1, 48000, 128, 0 },
+    { 1, 240, "1/32", 8, 1, 48000, 64, 0 },
+    { 1, 73, "1/8T", 3, 1, 44100, 100, 0 },
+};
+
+static midi_fx_api_v1_t *g_api;
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_RUNNING;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * Ideal times are kept as numerators over a common denominator so that a
+ * day of steps is compared without rounding:
+ *   step k at (k * A + (k odd ? S : 0)) / D samples.
+ * Internal sync: D = bpm * npb_num * 200, A = 60 * sr * npb_den * 200,
+ * S = 60 * sr * npb_den * swing. Clock sync has no swing and uses
+ * clocks_per_step * 60 * sr / (bpm * 24) per step, which is the same A / D.
+ */
+static void config_ratio(const soak_config_t *c, int64_t *a, int64_t *s, int64_t *d) {
+    *d = (int64_t)c->bpm * c->npb_num * 200;
+    *a = (int64_t)60 * c->sample_rate * c->npb_den * 200;
+    *s = c->clock_sync ? 0 : (int64_t)60 * c->sample_rate * c->npb_den * c->swing;
+}
+
+/* Internal steps with an ideal time at or before t / D samples. */
+static int64_t expected_steps(int64_t a, int64_t s, int64_t t) {
+    int64_t evens;
+    int64_t odds;
+    evens = t / (2 * a) + 1;
+    odds = t >= a + s ? (t - a - s) / (2 * a) + 1 : 0;
+    return evens + odds;
+}
+
+static void check_events(const soak_config_t *c, soak_result_t *res, uint8_t out[][3], int n, int64_t at,
+                         int64_t a, int64_t s, int64_t d, double gate_samples) {
+    int i;
+    for (i = 0; i < n; i++) {
+        int on = (out[i][0] & 0xF0) == 0x90 && out[i][2] > 0;
+        if (on) {
+            uint64_t k = res->steps++;
+            int64_t ideal = (int64_t)k * a + ((k & 1) ? s : 0);
+            double err = (double)ideal / (double)d - (double)at;
+            if (err < res->err_min) res->err_min = err;
+            if (err > res->err_max) res->err_max = err;
+            if (err < -1.0 || err > (double)c->block + 1.0) {
+                if (!res->failed) fprintf(stderr, "  step %llu at %lld, ideal %.3f\n",
+                                          (unsigned long long)k, (long long)at, (double)ideal / (double)d);
+                res->failed = 1;
+            }
+            if (res->note_open) {
+                if (!res->failed) fprintf(stderr, "  voice still open at step %llu\n", (unsigned long long)k);
+                res->failed = 1;
+            }
+            res->note_open = 1;
+            res->note_on_at = at;
+        } else if ((out[i][0] & 0xF0) == 0x80 || (out[i][0] & 0xF0) == 0x90) {
+            double gate_err = (double)(at - res->note_on_at) - gate_samples;
+            if (gate_err < 0.0) gate_err = -gate_err;
+            if (gate_err > res->gate_err_max) res->gate_err_max = gate_err;
+            if (!res->note_open || gate_err > (double)c->block + 1.0) {
+                if (!res->failed) fprintf(stderr, "  gate ends at %lld, opened at %lld\n",
+                                          (long long)at, (long long)res->note_on_at);
+                res->failed = 1;
+            }
+            res->note_open = 0;
+            res->gates++;
+        }
+    }
+}
+
+static int run_config(const soak_config_t *c, double hours) {
+    void *inst = g_api->create_instance("", NULL);
+    uint8_t out[MAX_OUT][3];
+    int lens[MAX_OUT];
+    uint8_t note_on[3] = { 0x90, 60, 100 };
+    uint8_t start[1] = { 0xFA };
+    uint8_t clock[1] = { 0xF8 };
+    char val[16];
+    soak_result_t res;
+    int64_t a;
+    int64_t s;
+    int64_t d;
+    int64_t end = (int64_t)(hours * 3600.0 * (double)c->sample_rate);
+    int64_t hour = (int64_t)3600 * c->sample_rate;
+    int64_t at = 0;
+    int64_t next_probe = hour;
+    int64_t clocks = 0;
+    double gate_samples;
+    double first_cost = 0.0;
+    double last_cost = 0.0;
+    double first_probe = -1.0;
+    double probe_ns = 0.0;
+    uint64_t window_ns = 0;
+    uint64_t window_ticks = 0;
+    int64_t expect_steps;
+    int clocks_per_step;
+    int steps_ok;
+    int ok;
+
+    memset(&res, 0, sizeof(res));
+    res.err_min = 1e30;
+    res.err_max = -1e30;
+    config_ratio(c, &a, &s, &d);
+    clocks_per_step = 24 * c->npb_den / c->npb_num;
+    gate_samples = c->clock_sync ? (double)(clocks_per_step * GATE_PCT / 100) * (double)a /
+                                       ((double)clocks_per_step * (double)d)
+                                 : (double)a / (double)d * GATE_PCT / 100.0;
+
+    g_api->set_param(inst, "sync", c->clock_sync ? "clock" : "internal");
+    g_api->set_param(inst, "lane1_steps", "1");
+    g_api->set_param(inst, "lane1_pulses", "1");
+    g_api->set_param(inst, "rate", c->rate);
+    snprintf(val, sizeof(val), "%d", GATE_PCT);
+    g_api->set_param(inst, "global_gate", val);
+    snprintf(val, sizeof(val), "%d", c->bpm);
+    g_api->set_param(inst, "bpm", val);
+    snprintf(val, sizeof(val), "%d", c->swing);
+    g_api->set_param(inst, "swing", val);
+    g_api->process_midi(inst, note_on, 3, out, lens, MAX_OUT);
+    g_api->process_midi(inst, start, 1, out, lens, MAX_OUT);
+
+    while (at < end) {
+        uint64_t t0 = now_ns();
+        int n;
+        if (c->clock_sync) {
+            /* Clock j (1-based) is due at j * A / (D * clocks_per_step). */
+            for (;;) {
+                int64_t due = (clocks + 1) * a / ((int64_t)clocks_per_step * d);
+                if (due >= at + c->block) break;
+                clocks++;
+                n = g_api->process_midi(inst, clock, 1, out, lens, MAX_OUT);
+                check_events(c, &res, out, n, at, a, s, d, gate_samples);
+            }
+        }
+        n = g_api->tick(inst, c->block, c->sample_rate, out, lens, MAX_OUT);
+        window_ns += now_ns() - t0;
+        window_ticks++;
+        check_events(c, &res, out, n, at, a, s, d, gate_samples);
+        at += c->block;
+
+        if (at >= next_probe || at >= end) {
+            double cost = (double)window_ns / (double)(window_ticks ? window_ticks : 1);
+            if (first_cost == 0.0) first_cost = cost;
+            last_cost = cost;
+            window_ns = 0;
+            window_ticks = 0;
+            next_probe += hour;
+            /* Re-derives the internal phase from the running total. */
+            if (!c->clock_sync && c->swing == 0) {
+                uint64_t p0 = now_ns();
+                snprintf(val, sizeof(val), "%d", c->bpm);
+                g_api->set_param(inst, "bpm", val);
+                probe_ns = (double)(now_ns() - p0);
+                if (first_probe < 0.0) first_probe = probe_ns;
+            }
+        }
+    }
+    g_api->destroy_instance(inst);
+
+    /* A step due exactly on the final block edge may round to either side. */
+    if (c->clock_sync) {
+        expect_steps = clocks / clocks_per_step + 1;
+        steps_ok = (int64_t)res.steps == expect_steps;
+    } else {
+        expect_steps = expected_steps(a, s, at * d);
+        steps_ok = (int64_t)res.steps == expect_steps ||
+                   (int64_t)res.steps == expected_steps(a, s, at * d - 1);
+    }
+    ok = !res.failed && steps_ok && res.gates + 1 >= res.steps &&
+         last_cost <= first_cost * COST_GROWTH_LIMIT + 50.0 &&
+         probe_ns <= first_probe * COST_GROWTH_LIMIT + 20000.0;
+    printf("%s %-8s bpm=%-3d rate=%-5s sr=%-5d block=%-3d swing=%-2d steps=%llu/%lld "
+           "err=[%.2f,%.2f] gate_err=%.2f ns/tick first=%.0f last=%.0f\n",
+           ok ? "ok  " : "FAIL", c->clock_sync ? "clock" : "internal", c->bpm, c->rate, c->sample_rate,
+           c->block, c->swing, (unsigned long long)res.steps, (long long)expect_steps, res.err_min,
+           res.err_max, res.gate_err_max, first_cost, last_cost);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    host_api_v1_t host;
+    double hours = argc > 1 ? atof(argv[1]) : 24.0;
+    size_t i;
+    int failed = 0;
+
+    if (hours <= 0.0) hours = 24.0;
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+    g_api = move_midi_fx_init(&host);
+    if (!g_api) return 1;
+
+    printf("soak: %.2f simulated hours per configuration\n", hours);
+    for (i = 0; i < sizeof(k_configs) / sizeof(k_configs[0]); i++) {
+        if (!run_config(&k_configs[i], hours)) failed = 1;
+        fflush(stdout);
+    }
+    if (failed) return 1;
+    printf("PASS: eucalypso soak\n");
+    return 0;
+}
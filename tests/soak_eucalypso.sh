@@ -0,0 +1,21 @@
+#!/usr/bin/env bash
+# Simulated long-duration soak and drift run. Usage: tests/soak_eucalypso.sh [hours]
+# Defaults to 24 simulated hours per configuration; runs in a few minutes.
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+MOVE_ANYTHING_SRC="${MOVE_ANYTHING_SRC:-$ROOT_DIR/../move-anything/src}"
+BIN="$ROOT_DIR/build/tests/soak_eucalypso"
+
+mkdir -p "$(dirname "$BIN")"
+
+cc -std=c11 -Wall -Wextra -Werror -O2 \
+  -DEUCALYPSO_DEBUG_LOG=0 \
+  -I"$MOVE_ANYTHING_SRC" \
+  -I"$ROOT_DIR/src" \
+  "$ROOT_DIR/tests/soak_eucalypso.c" \
+  "$ROOT_DIR/src/dsp/eucalypso.c" \
+  -o "$BIN" \
+  -lm
+
+"$BIN" "${1:-24}"
@@ -0,0 +1,159 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+static midi_fx_api_v1_t *g_api;
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_STOPPED;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+/* Note-clocked, three one-step lanes playing register notes 1-3. */
+static void *make(const char *capture_ms) {
+    void *inst = g_api->create_instance("", NULL);
+    char key[32];
+    char val[8];
+    int i;
+    g_api->set_param(inst, "sync", "note");
+    g_api->set_param(inst, "capture_ms", capture_ms);
+    g_api->set_param(inst, "global_gate", "10");
+    for (i = 1; i <= 3; i++) {
+        snprintf(key, sizeof(key), "lane%d_enabled", i);
+        g_api->set_param(inst, key, "on");
+        snprintf(key, sizeof(key), "lane%d_steps", i);
+        g_api->set_param(inst, key, "1");
+        snprintf(key, sizeof(key), "lane%d_pulses", i);
+        g_api->set_param(inst, key, "1");
+        snprintf(key, sizeof(key), "lane%d_note", i);
+        snprintf(val, sizeof(val), "%d", i);
+        g_api->set_param(inst, key, val);
+    }
+    return inst;
+}
+
+static void key(void *inst, uint8_t status, uint8_t note) {
+    uint8_t out[16][3];
+    int lens[16];
+    uint8_t msg[3] = { status, note, status == 0x90 ? 100 : 0 };
+    g_api->process_midi(inst, msg, 3, out, lens, 16);
+}
+
+/* 128 frames at 44.1 kHz is about 2.9 ms. */
+static void wait_blocks(void *inst, int blocks) {
+    uint8_t out[16][3];
+    int lens[16];
+    int i;
+    for (i = 0; i < blocks; i++) g_api->tick(inst, 128, 44100, out, lens, 16);
+}
+
+/* Returns the number of note-ons from one trigger; notes[] gets a bitmask of
+ * 60/64/67 (bits 0-2). */
+static int trigger(void *inst, int *notes) {
+    uint8_t out[16][3];
+    int lens[16];
+    uint8_t trig[3] = { 0x90, 36, 100 };
+    int n = g_api->process_midi(inst, trig, 3, out, lens, 16);
+    int ons = 0;
+    int i;
+    *notes = 0;
+    for (i = 0; i < n; i++) {
+        if ((out[i][0] & 0xF0) != 0x90 || out[i][2] == 0) continue;
+        ons++;
+        if (out[i][1] == 60) *notes |= 1;
+        if (out[i][1] == 64) *notes |= 2;
+        if (out[i][1] == 67) *notes |= 4;
+    }
+    wait_blocks(inst, 40);
+    return ons;
+}
+
+int main(void) {
+    host_api_v1_t host;
+    char state[8192];
+    char runtime[8192];
+    char buf[32];
+    void *inst;
+    void *copy;
+    int notes;
+    int n;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+    g_api = move_midi_fx_init(&host);
+    if (g_api == NULL) fail("api init");
+
+    /* Without a window a step between chord notes plays the partial chord. */
+    inst = make("0");
+    key(inst, 0x90, 60);
+    wait_blocks(inst, 1);
+    n = trigger(inst, &notes);
+    if (n != 1 || notes != 1) fail("no capture: partial chord plays");
+    g_api->destroy_instance(inst);
+
+    /* With a 20 ms window a step inside the burst sees the old register. */
+    inst = make("20");
+    g_api->get_param(inst, "capture_ms", buf, (int)sizeof(buf));
+    if (strcmp(buf, "20") != 0) fail("capture_ms readback");
+    key(inst, 0x90, 60);
+    wait_blocks(inst, 1);
+    key(inst, 0x90, 64);
+    n = trigger(inst, &notes);
+    if (n != 0) fail("step inside the window does not play a partial chord");
+    g_api->destroy_instance(inst);
+
+    /* The whole burst is committed together once the window closes. */
+    inst = make("20");
+    key(inst, 0x90, 60);
+    wait_blocks(inst, 1);
+    key(inst, 0x90, 64);
+    wait_blocks(inst, 1);
+    key(inst, 0x90, 67);
+    wait_blocks(inst, 8);
+    n = trigger(inst, &notes);
+    if (n != 3 || notes != 7) fail("full chord after the window");
+
+    /* A chord change inside a window swaps the register in one go. */
+    key(inst, 0x80, 67);
+    key(inst, 0x80, 64);
+    n = trigger(inst, &notes);
+    if (n != 3 || notes != 7) fail("releases wait for the window");
+    n = trigger(inst, &notes);
+    if (n != 1 || notes != 1) fail("releases applied after the window");
+
+    /* Queued events survive a runtime handoff. */
+    key(inst, 0x90, 64);
+    key(inst, 0x90, 67);
+    g_api->get_param(inst, "state", state, (int)sizeof(state));
+    g_api->get_param(inst, "runtime_state", runtime, (int)sizeof(runtime));
+    if (strstr(state, "\"capture_ms\":20") == NULL) fail("capture_ms in state");
+    copy = g_api->create_instance("", NULL);
+    g_api->set_param(copy, "state", state);
+    g_api->set_param(copy, "runtime_state", runtime);
+    n = trigger(copy, &notes);
+    if (n != 1 || notes != 1) fail("handoff keeps the window open");
+    n = trigger(copy, &notes);
+    if (n != 3 || notes != 7) fail("handoff commits the queued chord");
+    g_api->destroy_instance(copy);
+
+    /* Turning the window off commits anything still queued. */
+    key(inst, 0x80, 67);
+    g_api->set_param(inst, "capture_ms", "0");
+    n = trigger(inst, &notes);
+    if (n != 2 || notes != 3) fail("disabling capture commits queued events");
+    g_api->destroy_instance(inst);
+
+    printf("PASS: eucalypso capture\n");
+    return 0;
+}
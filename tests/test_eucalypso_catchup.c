@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_RUNNING;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+static int count_note_ons(uint8_t out_msgs[][3], int out_lens[], int count) {
+    int i;
+    int n = 0;
+    for (i = 0; i < count; i++) {
+        if (out_lens[i] >= 3 && (out_msgs[i][0] & 0xF0) == 0x90 && out_msgs[i][2] > 0) n++;
+    }
+    return n;
+}
+
+static void send_midi(midi_fx_api_v1_t *api, void *inst, uint8_t s, uint8_t d1, uint8_t d2) {
+    uint8_t in[3];
+    uint8_t out_msgs[16][3];
+    int out_lens[16];
+    in[0] = s;
+    in[1] = d1;
+    in[2] = d2;
+    (void)api->process_midi(inst, in, 3, out_msgs, out_lens, 16);
+}
+
+static int get_int(midi_fx_api_v1_t *api, void *inst, const char *key) {
+    char buf[64];
+    memset(buf, 0, sizeof(buf));
+    if (api->get_param(inst, key, buf, (int)sizeof(buf)) <= 0) fail("missing metric");
+    return atoi(buf);
+}
+
+/* 120 BPM 1/16 is 5512.5 samples per step, so a 44100-frame stall leaves
+ * eight steps due in a single tick. Returns note-ons emitted by the stall. */
+static int run_stall(midi_fx_api_v1_t *api, void *inst) {
+    uint8_t out_msgs[128][3];
+    int out_lens[128];
+    int n;
+    api->set_param(inst, "lane1_steps", "1");
+    api->set_param(inst, "lane1_pulses", "1");
+    api->set_param(inst, "global_gate", "50");
+    (void)api->tick(inst, 128, 44100, out_msgs, out_lens, 128);
+    send_midi(api, inst, 0x90, 60, 100);
+    send_midi(api, inst, 0xFA, 0, 0);
+    n = api->tick(inst, 128, 44100, out_msgs, out_lens, 128);
+    if (count_note_ons(out_msgs, out_lens, n) != 1) fail("expected the start step to play");
+    n = api->tick(inst, 44100, 44100, out_msgs, out_lens, 128);
+    return count_note_ons(out_msgs, out_lens, n);
+}
+
+static void test_policy(midi_fx_api_v1_t *api, const char *policy, int expect_on, int expect_skipped) {
+    void *inst = api->create_instance(".", NULL);
+    int ons;
+    if (!inst) fail("create_instance failed");
+    api->set_param(inst, "catchup", policy);
+    api->set_param(inst, "catchup_ms", "30");
+    ons = run_stall(api, inst);
+    if (ons != expect_on) {
+        fprintf(stderr, "policy=%s note_ons=%d\n", policy, ons);
+        fail("unexpected note count after stall");
+    }
+    if (get_int(api, inst, "backlog_depth") != 8) fail("backlog_depth should report eight due steps");
+    if (get_int(api, inst, "backlog_skipped") != expect_skipped) fail("unexpected skipped step count");
+    api->destroy_instance(inst);
+}
+
+/* Ordinary blocks with no stall: a zero age limit must still play every step
+ * that falls due inside a block. 10 s at 1/16 and 120 BPM is 80 steps. */
+static void test_skip_without_stall(midi_fx_api_v1_t *api, const char *ms) {
+    void *inst = api->create_instance(".", NULL);
+    uint8_t out_msgs[32][3];
+    int out_lens[32];
+    int ons = 0;
+    int b;
+    if (!inst) fail("create_instance failed");
+    api->set_param(inst, "catchup", "skip");
+    api->set_param(inst, "catchup_ms", ms);
+    api->set_param(inst, "lane1_steps", "1");
+    api->set_param(inst, "lane1_pulses", "1");
+    api->set_param(inst, "global_gate", "50");
+    send_midi(api, inst, 0x90, 60, 100);
+    send_midi(api, inst, 0xFA, 0, 0);
+    for (b = 0; b < 441000 / 128; b++) {
+        int n = api->tick(inst, 128, 44100, out_msgs, out_lens, 32);
+        ons += count_note_ons(out_msgs, out_lens, n);
+    }
+    if (ons != 80) {
+        fprintf(stderr, "catchup_ms=%s note_ons=%d\n", ms, ons);
+        fail("skip dropped on-time steps");
+    }
+    if (get_int(api, inst, "backlog_skipped") != 0) fail("skip counted on-time steps");
+    api->destroy_instance(inst);
+}
+
+int main(void) {
+    host_api_v1_t host;
+    midi_fx_api_v1_t *api;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+
+    api = move_midi_fx_init(&host);
+    if (!api || !api->create_instance || !api->process_midi || !api->tick || !api->destroy_instance) {
+        fail("eucalypso API init/callbacks missing");
+    }
+
+    test_policy(api, "all", 8, 0);
+    test_policy(api, "latest", 1, 7);
+    /* Only the newest step (due ~1.5k samples before block end) is under 30 ms old. */
+    test_policy(api, "skip", 1, 7);
+    test_skip_without_stall(api, "0");
+    test_skip_without_stall(api, "1");
+    test_skip_without_stall(api, "2");
+
+    printf("PASS: eucalypso backlog catch-up policy\n");
+    return 0;
+}
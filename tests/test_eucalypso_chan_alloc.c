@@ -0,0 +1,153 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+static midi_fx_api_v1_t *g_api;
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_STOPPED;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+/* Note-clocked one-step lanes over a four-note chord; lane i plays note i. */
+static void *make(const char *mode, const char *lo, const char *hi, int lanes) {
+    void *inst = g_api->create_instance("", NULL);
+    uint8_t out[16][3];
+    int lens[16];
+    uint8_t chord[4][3] = { { 0x90, 60, 100 }, { 0x90, 62, 100 }, { 0x90, 64, 100 }, { 0x90, 65, 100 } };
+    char key[32];
+    int i;
+    g_api->set_param(inst, "sync", "note");
+    g_api->set_param(inst, "chan_mode", mode);
+    g_api->set_param(inst, "chan_lo", lo);
+    g_api->set_param(inst, "chan_hi", hi);
+    g_api->set_param(inst, "global_gate", "50");
+    for (i = 1; i <= lanes; i++) {
+        snprintf(key, sizeof(key), "lane%d_enabled", i);
+        g_api->set_param(inst, key, "on");
+        snprintf(key, sizeof(key), "lane%d_steps", i);
+        g_api->set_param(inst, key, "1");
+        snprintf(key, sizeof(key), "lane%d_pulses", i);
+        g_api->set_param(inst, key, "1");
+    }
+    for (i = 0; i < 4; i++) g_api->process_midi(inst, chord[i], 3, out, lens, 16);
+    return inst;
+}
+
+/* One trigger; chans[] receives the 1-based channel of each note-on. */
+static int step(void *inst, int *chans, uint8_t out[16][3]) {
+    int lens[16];
+    uint8_t trig[3] = { 0x90, 36, 100 };
+    int n = g_api->process_midi(inst, trig, 3, out, lens, 16);
+    int ons = 0;
+    int i;
+    for (i = 0; i < n; i++) {
+        if ((out[i][0] & 0xF0) == 0x90 && out[i][2] > 0) chans[ons++] = (out[i][0] & 0x0F) + 1;
+    }
+    return n;
+}
+
+/* Ticks past the gates; returns 1 when every note-off used the channel its
+ * note-on was sent on. */
+static int release(void *inst, const int *on_chan) {
+    uint8_t out[16][3];
+    int lens[16];
+    int n = g_api->tick(inst, 48000, 48000, out, lens, 16);
+    int ok = n > 0;
+    int i;
+    for (i = 0; i < n; i++) {
+        int note = out[i][1];
+        if ((out[i][0] & 0x0F) + 1 != on_chan[note]) ok = 0;
+    }
+    return ok;
+}
+
+int main(void) {
+    host_api_v1_t host;
+    uint8_t out[16][3];
+    int chans[8];
+    int on_chan[128];
+    char state[8192];
+    char runtime[8192];
+    void *inst;
+    void *copy;
+    int lens[16];
+    int n;
+    int i;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+    g_api = move_midi_fx_init(&host);
+    if (g_api == NULL) fail("api init");
+
+    /* Off: everything on channel 1, as before. */
+    inst = make("off", "2", "5", 3);
+    n = step(inst, chans, out);
+    if (n != 3 || chans[0] != 1 || chans[1] != 1 || chans[2] != 1) fail("off keeps channel 1");
+    g_api->destroy_instance(inst);
+
+    /* Round robin over 2-5 with three notes per step keeps rotating. */
+    inst = make("rr", "2", "5", 3);
+    step(inst, chans, out);
+    if (chans[0] != 2 || chans[1] != 3 || chans[2] != 4) fail("rr first step");
+    on_chan[60] = chans[0];
+    on_chan[62] = chans[1];
+    on_chan[64] = chans[2];
+    if (!release(inst, on_chan)) fail("note-offs follow their channel");
+    step(inst, chans, out);
+    if (chans[0] != 5 || chans[1] != 2 || chans[2] != 3) fail("rr continues from the cursor");
+    g_api->destroy_instance(inst);
+
+    /* LRU prefers channels never used, then the one released longest ago. */
+    inst = make("lru", "2", "5", 3);
+    step(inst, chans, out);
+    if (chans[0] != 2 || chans[1] != 3 || chans[2] != 4) fail("lru first step");
+    on_chan[60] = 2;
+    on_chan[62] = 3;
+    on_chan[64] = 4;
+    if (!release(inst, on_chan)) fail("lru note-offs");
+    step(inst, chans, out);
+    if (chans[0] != 5 || chans[1] != 2 || chans[2] != 3) fail("lru picks the least recently used");
+    g_api->destroy_instance(inst);
+
+    /* Three notes on two channels: the oldest voice is stolen, so each
+     * channel stays monophonic. */
+    inst = make("rr", "2", "3", 3);
+    n = step(inst, chans, out);
+    if (chans[0] != 2 || chans[1] != 3 || chans[2] != 2) fail("steal reuses the oldest channel");
+    for (i = 0; i < n; i++) {
+        if ((out[i][0] & 0xF0) == 0x80) {
+            if (out[i][0] != 0x81 || out[i][1] != 60) fail("stolen voice released on its channel");
+        }
+    }
+
+    /* Sounding voices keep their channel across a runtime handoff. */
+    g_api->get_param(inst, "state", state, (int)sizeof(state));
+    g_api->get_param(inst, "runtime_state", runtime, (int)sizeof(runtime));
+    if (strstr(state, "\"chan_mode\":\"rr\",\"chan_lo\":2,\"chan_hi\":3") == NULL) fail("channel params in state");
+    copy = g_api->create_instance("", NULL);
+    g_api->set_param(copy, "state", state);
+    g_api->set_param(copy, "runtime_state", runtime);
+    on_chan[62] = 3;
+    on_chan[64] = 2;
+    if (!release(copy, on_chan)) fail("note-offs after handoff use the original channels");
+    n = step(copy, chans, out);
+    if (n < 3) fail("handoff copy plays");
+    g_api->tick(copy, 48000, 48000, out, lens, 16);
+    g_api->destroy_instance(copy);
+    g_api->destroy_instance(inst);
+
+    printf("PASS: eucalypso chan alloc\n");
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+#define SAMPLE_RATE 48000
+#define CLOCK_SAMPLES 1000
+#define STEP_SAMPLES (6 * CLOCK_SAMPLES)
+#define MAX_EVENTS 32
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_RUNNING;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+typedef struct {
+    long on[MAX_EVENTS];
+    long off[MAX_EVENTS];
+    int ons;
+    int offs;
+} note_times_t;
+
+static void collect(note_times_t *t, uint8_t out[][3], int n, long sample) {
+    int i;
+    for (i = 0; i < n; i++) {
+        int on = (out[i][0] & 0xF0) == 0x90 && out[i][2] > 0;
+        if (on && t->ons < MAX_EVENTS) t->on[t->ons++] = sample;
+        else if (!on && t->offs < MAX_EVENTS) t->off[t->offs++] = sample;
+    }
+}
+
+/* A one-step lane at 1/16 (six clocks per step) under a 120 BPM MIDI clock,
+ * with a 50% gate, run in blocks of block frames. */
+static void run(midi_fx_api_v1_t *api, const char *swing, int block, note_times_t *t) {
+    void *inst = api->create_instance("", NULL);
+    uint8_t out[16][3];
+    int lens[16];
+    uint8_t held[3] = { 0x90, 60, 100 };
+    uint8_t start[1] = { 0xFA };
+    uint8_t clock[1] = { 0xF8 };
+    long sample;
+
+    memset(t, 0, sizeof(*t));
+    api->set_param(inst, "sync", "clock");
+    api->set_param(inst, "lane1_steps", "1");
+    api->set_param(inst, "lane1_pulses", "1");
+    api->set_param(inst, "global_gate", "50");
+    api->set_param(inst, "swing", swing);
+    api->process_midi(inst, held, 3, out, lens, 16);
+    api->process_midi(inst, start, 1, out, lens, 16);
+    for (sample = 0; sample < STEP_SAMPLES * 8; sample += block) {
+        int n;
+        if (sample > 0 && sample % CLOCK_SAMPLES == 0) {
+            n = api->process_midi(inst, clock, 1, out, lens, 16);
+            collect(t, out, n, sample);
+        }
+        n = api->tick(inst, block, SAMPLE_RATE, out, lens, 16);
+        collect(t, out, n, sample);
+    }
+    api->destroy_instance(inst);
+}
+
+int main(void) {
+    host_api_v1_t host;
+    midi_fx_api_v1_t *api;
+    note_times_t t;
+    int k;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+    api = move_midi_fx_init(&host);
+    if (api == NULL) fail("api init");
+
+    run(api, "0", 1, &t);
+    if (t.ons < 7) fail("straight steps");
+    for (k = 1; k < 7; k++) {
+        if (labs(t.on[k] - (long)k * STEP_SAMPLES) > 1) fail("straight steps on clock boundaries");
+    }
+
+    /* Swing 50 delays odd steps by a quarter step (1500 samples); even steps
+     * stay on the boundary and gates keep their length. */
+    run(api, "50", 1, &t);
+    if (t.ons < 7 || t.offs < 6) fail("swung steps");
+    for (k = 1; k < 7; k++) {
+        long want = (long)k * STEP_SAMPLES + ((k & 1) ? STEP_SAMPLES / 4 : 0);
+        if (labs(t.on[k] - want) > 2) {
+            fprintf(stderr, "step %d at %ld, want %ld\n", k, t.on[k], want);
+            fail("odd steps delayed by the swing offset");
+        }
+        if (labs((t.off[k] - t.on[k]) - STEP_SAMPLES / 2) > CLOCK_SAMPLES) fail("swung gate length");
+    }
+
+    /* With 250-frame blocks the delayed step lands in the block holding its
+     * due time rather than on the next clock. */
+    run(api, "50", 250, &t);
+    if (t.ons < 7) fail("swung steps in blocks");
+    for (k = 1; k < 7; k += 2) {
+        long want = (long)k * STEP_SAMPLES + STEP_SAMPLES / 4;
+        if (t.on[k] < want - 250 || t.on[k] > want) fail("delayed step in its due block");
+    }
+
+    printf("PASS: eucalypso clock swing\n");
+    return 0;
+}
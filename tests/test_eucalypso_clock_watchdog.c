@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+#define BLOCK_FRAMES 128
+#define SAMPLE_RATE 44100
+#define CLOCK_INTERVAL 918.75 /* 120 BPM, 24 PPQN */
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_RUNNING;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+static int count_status(uint8_t out_msgs[][3], int out_lens[], int count, uint8_t status) {
+    int i;
+    int n = 0;
+    for (i = 0; i < count; i++) {
+        if (out_lens[i] >= 3 && (out_msgs[i][0] & 0xF0) == status) n++;
+    }
+    return n;
+}
+
+static int send_midi(midi_fx_api_v1_t *api, void *inst, uint8_t s, uint8_t d1, uint8_t d2,
+                     uint8_t out_msgs[][3], int out_lens[], int max_out) {
+    uint8_t in[3];
+    in[0] = s;
+    in[1] = d1;
+    in[2] = d2;
+    return api->process_midi(inst, in, s >= 0xF8 || s == 0xFA ? 1 : 3, out_msgs, out_lens, max_out);
+}
+
+static int has_error(midi_fx_api_v1_t *api, void *inst, const char *needle) {
+    char buf[256];
+    memset(buf, 0, sizeof(buf));
+    (void)api->get_param(inst, "error", buf, (int)sizeof(buf));
+    return strstr(buf, needle) != NULL;
+}
+
+static void test_lost_clock_releases_gates(midi_fx_api_v1_t *api) {
+    void *inst = api->create_instance(".", NULL);
+    uint8_t out_msgs[64][3];
+    int out_lens[64];
+    int n;
+    int block;
+    int note_ons = 0;
+    int note_offs = 0;
+    int clocks_sent = 0;
+    int lost_block = -1;
+    int off_block = -1;
+    double next_clock = 0.0;
+    double now = 0.0;
+
+    if (!inst) fail("create_instance failed");
+
+    api->set_param(inst, "sync", "clock");
+    api->set_param(inst, "clock_loss_mult", "4");
+    api->set_param(inst, "lane1_steps", "1");
+    api->set_param(inst, "lane1_pulses", "1");
+    api->set_param(inst, "global_gate", "1600"); /* 16 steps = 96 clocks */
+    (void)send_midi(api, inst, 0x90, 60, 100, out_msgs, out_lens, 64);
+    (void)send_midi(api, inst, 0xFA, 0, 0, out_msgs, out_lens, 64);
+
+    for (block = 0; block < 2000; block++) {
+        while (clocks_sent < 12 && next_clock <= now) {
+            n = send_midi(api, inst, 0xF8, 0, 0, out_msgs, out_lens, 64);
+            note_offs += count_status(out_msgs, out_lens, n, 0x80);
+            clocks_sent++;
+            next_clock += CLOCK_INTERVAL;
+        }
+        n = api->tick(inst, BLOCK_FRAMES, SAMPLE_RATE, out_msgs, out_lens, 64);
+        note_ons += count_status(out_msgs, out_lens, n, 0x90);
+        note_offs += count_status(out_msgs, out_lens, n, 0x80);
+        now += BLOCK_FRAMES;
+        if (lost_block < 0 && has_error(api, inst, "clock lost")) lost_block = block;
+        if (off_block < 0 && note_offs > 0) off_block = block;
+    }
+
+    if (note_ons < 1) fail("expected a step to fire while clock was running");
+    if (lost_block < 0) fail("expected clock lost warning after clock stopped");
+    if ((double)lost_block * BLOCK_FRAMES > 16.0 * CLOCK_INTERVAL) {
+        fail("clock loss detected too late");
+    }
+    if (off_block < 0) fail("sounding voice never released after clock loss");
+    if ((double)off_block * BLOCK_FRAMES > 100.0 * CLOCK_INTERVAL) {
+        fail("voice outlived its gate after clock loss");
+    }
+
+    n = send_midi(api, inst, 0xF8, 0, 0, out_msgs, out_lens, 64);
+    (void)n;
+    if (has_error(api, inst, "clock lost")) fail("clock lost warning should clear when clock returns");
+
+    api->destroy_instance(inst);
+}
+
+int main(void) {
+    host_api_v1_t host;
+    midi_fx_api_v1_t *api;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+
+    api = move_midi_fx_init(&host);
+    if (!api || !api->create_instance || !api->process_midi || !api->tick || !api->destroy_instance) {
+        fail("eucalypso API init/callbacks missing");
+    }
+
+    test_lost_clock_releases_gates(api);
+
+    printf("PASS: eucalypso clock loss watchdog\n");
+    return 0;
+}
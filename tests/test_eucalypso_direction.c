@@ -0,0 +1,137 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+#define STEPS 24
+
+static midi_fx_api_v1_t *g_api;
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_STOPPED;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+/* A held note 60 and note-clocked steps, so each trigger returns its step. */
+static void *make(const char *steps, const char *pulses, const char *dir, const char *seed) {
+    void *inst = g_api->create_instance("", NULL);
+    uint8_t out[16][3];
+    int lens[16];
+    uint8_t held[3] = { 0x90, 60, 100 };
+    g_api->set_param(inst, "sync", "note");
+    g_api->set_param(inst, "lane1_steps", steps);
+    g_api->set_param(inst, "lane1_pulses", pulses);
+    g_api->set_param(inst, "lane1_dir", dir);
+    g_api->set_param(inst, "lane1_dir_seed", seed);
+    g_api->set_param(inst, "lane1_n_rnd", "0");
+    g_api->process_midi(inst, held, 3, out, lens, 16);
+    return inst;
+}
+
+/* hits[i] is 1 when trigger i played the lane. */
+static void run(void *inst, int count, int *hits) {
+    uint8_t out[16][3];
+    int lens[16];
+    uint8_t trig[3] = { 0x90, 36, 100 };
+    int i;
+    for (i = 0; i < count; i++) {
+        int n = g_api->process_midi(inst, trig, 3, out, lens, 16);
+        int j;
+        hits[i] = 0;
+        for (j = 0; j < n; j++) {
+            if ((out[j][0] & 0xF0) == 0x90 && out[j][2] > 0) hits[i] = 1;
+        }
+        g_api->tick(inst, 4800, 48000, out, lens, 16);
+    }
+}
+
+static int only_hits_at(const int *hits, int count, int period, int phase) {
+    int i;
+    for (i = 0; i < count; i++) {
+        if (hits[i] != ((i % period) == phase)) return 0;
+    }
+    return 1;
+}
+
+int main(void) {
+    host_api_v1_t host;
+    void *a;
+    void *b;
+    int hits[STEPS];
+    int other[STEPS];
+    char state[8192];
+    char runtime[8192];
+    int total;
+    int i;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+    g_api = move_midi_fx_init(&host);
+    if (g_api == NULL) fail("api init");
+
+    /* One pulse on position 0 of four. */
+    a = make("4", "1", "fwd", "0");
+    run(a, STEPS, hits);
+    if (!only_hits_at(hits, STEPS, 4, 0)) fail("forward plays position 0 first");
+    g_api->destroy_instance(a);
+
+    a = make("4", "1", "rev", "0");
+    run(a, STEPS, hits);
+    if (!only_hits_at(hits, STEPS, 4, 3)) fail("reverse plays position 0 last");
+    g_api->destroy_instance(a);
+
+    /* 0 1 2 3 2 1 | 0 ...: position 0 once per six steps. */
+    a = make("4", "1", "pingpong", "0");
+    run(a, STEPS, hits);
+    if (!only_hits_at(hits, STEPS, 6, 0)) fail("pingpong turns without repeating the ends");
+    g_api->destroy_instance(a);
+
+    /* Changing direction mid-run takes effect on the next step. */
+    a = make("4", "1", "fwd", "0");
+    run(a, 5, hits);
+    g_api->set_param(a, "lane1_dir", "rev");
+    run(a, 3, hits);
+    if (hits[0] != 0 || hits[1] != 0 || hits[2] != 1) fail("direction switch keeps the cycle position");
+    g_api->destroy_instance(a);
+
+    /* Random direction is a function of (seed, step): same seed, same
+     * sequence; state + runtime_state handoff resumes it exactly. */
+    a = make("8", "3", "rand", "7");
+    b = make("8", "3", "rand", "7");
+    run(a, STEPS, hits);
+    run(b, STEPS, other);
+    if (memcmp(hits, other, sizeof(hits)) != 0) fail("random direction is deterministic");
+    g_api->destroy_instance(b);
+    b = make("8", "3", "rand", "8");
+    run(b, STEPS, other);
+    if (memcmp(hits, other, sizeof(hits)) == 0) fail("random direction follows its seed");
+    g_api->destroy_instance(b);
+
+    g_api->get_param(a, "state", state, (int)sizeof(state));
+    g_api->get_param(a, "runtime_state", runtime, (int)sizeof(runtime));
+    if (strstr(state, "\"lane1_dir\":\"rand\"") == NULL) fail("lane dir in state");
+    if (strstr(state, "\"lane1_dir_seed\":7") == NULL) fail("lane dir_seed in state");
+    b = g_api->create_instance("", NULL);
+    g_api->set_param(b, "state", state);
+    g_api->set_param(b, "runtime_state", runtime);
+    run(a, STEPS, hits);
+    run(b, STEPS, other);
+    if (memcmp(hits, other, sizeof(hits)) != 0) fail("random direction resumes after handoff");
+    for (i = 0, total = 0; i < STEPS; i++) total += hits[i];
+    if (total <= 0) fail("random direction plays hits");
+    g_api->destroy_instance(a);
+    g_api->destroy_instance(b);
+
+    printf("PASS: eucalypso direction\n");
+    return 0;
+}
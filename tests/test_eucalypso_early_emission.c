@@ -0,0 +1,120 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+#define SAMPLE_RATE 48000
+#define STEP_SAMPLES 6000
+#define GATE_SAMPLES 3000
+#define MAX_EVENTS 32
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_STOPPED;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+typedef struct {
+    long on[MAX_EVENTS];
+    long off[MAX_EVENTS];
+    int ons;
+    int offs;
+} note_times_t;
+
+/* Two one-step lanes on held notes 60 (lane 1) and 64 (lane 2), 120 BPM
+ * 1/16 with a 50% gate, run in one-frame blocks. */
+static void run(midi_fx_api_v1_t *api, const char *global_ms, const char *lane1_ms, note_times_t times[2]) {
+    void *inst = api->create_instance("", NULL);
+    uint8_t out[16][3];
+    int lens[16];
+    uint8_t chord[2][3] = { { 0x90, 60, 100 }, { 0x90, 64, 100 } };
+    uint8_t start[1] = { 0xFA };
+    long sample;
+    int i;
+
+    memset(times, 0, sizeof(note_times_t) * 2);
+    api->set_param(inst, "lane1_steps", "1");
+    api->set_param(inst, "lane1_pulses", "1");
+    api->set_param(inst, "lane2_enabled", "on");
+    api->set_param(inst, "lane2_steps", "1");
+    api->set_param(inst, "lane2_pulses", "1");
+    api->set_param(inst, "global_gate", "50");
+    api->set_param(inst, "early_ms", global_ms);
+    api->set_param(inst, "lane1_early_ms", lane1_ms);
+    for (i = 0; i < 2; i++) api->process_midi(inst, chord[i], 3, out, lens, 16);
+    api->process_midi(inst, start, 1, out, lens, 16);
+
+    for (sample = 0; sample < STEP_SAMPLES * 8; sample++) {
+        int n = api->tick(inst, 1, SAMPLE_RATE, out, lens, 16);
+        for (i = 0; i < n; i++) {
+            note_times_t *t = &times[out[i][1] == 60 ? 0 : 1];
+            int on = (out[i][0] & 0xF0) == 0x90 && out[i][2] > 0;
+            if (on && t->ons < MAX_EVENTS) t->on[t->ons++] = sample;
+            else if (!on && t->offs < MAX_EVENTS) t->off[t->offs++] = sample;
+        }
+    }
+    api->destroy_instance(inst);
+}
+
+static int near(long got, long want) {
+    return labs(got - want) <= 1;
+}
+
+int main(void) {
+    host_api_v1_t host;
+    midi_fx_api_v1_t *api;
+    note_times_t base[2];
+    note_times_t early[2];
+    void *inst;
+    char buf[4096];
+    int k;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+    api = move_midi_fx_init(&host);
+    if (api == NULL) fail("api init");
+
+    run(api, "0", "0", base);
+    if (base[0].ons < 7 || base[1].ons < 7) fail("baseline steps");
+    for (k = 1; k < 7; k++) {
+        if (!near(base[0].on[k], (long)k * STEP_SAMPLES)) fail("baseline lane 1 on grid");
+        if (!near(base[1].on[k], (long)k * STEP_SAMPLES)) fail("baseline lane 2 on grid");
+    }
+
+    /* Global 10 ms plus 20 ms on lane 1: lane 1 leads by 1440 samples,
+     * lane 2 by 480. */
+    run(api, "10", "20", early);
+    if (early[0].ons < 7 || early[1].ons < 7) fail("early steps");
+    for (k = 1; k < 7; k++) {
+        if (!near(early[0].on[k], (long)k * STEP_SAMPLES - 1440) ||
+            !near(early[1].on[k], (long)k * STEP_SAMPLES - 480)) {
+            fprintf(stderr, "step %d: lane1 %ld lane2 %ld\n", k, early[0].on[k], early[1].on[k]);
+            fail("lanes emitted ahead by their offset");
+        }
+    }
+    for (k = 1; k < 6; k++) {
+        if (!near(early[0].off[k] - early[0].on[k], GATE_SAMPLES)) fail("lane 1 gate follows its note-on");
+        if (!near(early[1].off[k] - early[1].on[k], GATE_SAMPLES)) fail("lane 2 gate follows its note-on");
+    }
+
+    inst = api->create_instance("", NULL);
+    api->set_param(inst, "early_ms", "999");
+    api->set_param(inst, "lane3_early_ms", "15");
+    api->get_param(inst, "early_ms", buf, (int)sizeof(buf));
+    if (strcmp(buf, "200") != 0) fail("early_ms clamps");
+    api->get_param(inst, "state", buf, (int)sizeof(buf));
+    if (strstr(buf, "\"lane3_early_ms\":15") == NULL) fail("lane early_ms in state");
+    api->destroy_instance(inst);
+
+    printf("PASS: eucalypso early emission\n");
+    return 0;
+}
@@ -0,0 +1,227 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+#define BLOCK 128
+#define SAMPLE_RATE 44100
+#define BLOCKS 4000
+#define HANDOFF_BLOCK 2500
+#define WALK_BLOCKS 12000
+#define SEEK_BLOCK 8000
+#define SEEK_CYCLES 1000000ull
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_STOPPED;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void *make_instance(midi_fx_api_v1_t *api, const char *evolve, const char *lane1_steps) {
+    void *inst = api->create_instance("", NULL);
+    uint8_t out[64][3];
+    int lens[64];
+    uint8_t chord[3][3] = { { 0x90, 60, 100 }, { 0x90, 64, 100 }, { 0x90, 67, 100 } };
+    uint8_t start[1] = { 0xFA };
+    int i;
+    if (!inst) fail("create_instance failed");
+    api->set_param(inst, "lane1_steps", lane1_steps);
+    api->set_param(inst, "lane1_pulses", "3");
+    api->set_param(inst, "lane1_n_rnd", "60");
+    api->set_param(inst, "lane2_enabled", "on");
+    api->set_param(inst, "lane2_steps", "5");
+    api->set_param(inst, "lane2_pulses", "2");
+    api->set_param(inst, "evolve", evolve);
+    api->set_param(inst, "evolve_seed", "321");
+    for (i = 0; i < 3; i++) api->process_midi(inst, chord[i], 3, out, lens, 64);
+    api->process_midi(inst, start, 1, out, lens, 64);
+    return inst;
+}
+
+/* Packs a block's note-ons on one channel (-1 = any) into a comparable
+ * signature. */
+static uint32_t block_sig(uint8_t out[][3], int n, int chan) {
+    uint32_t sig = 0;
+    int i;
+    for (i = 0; i < n; i++) {
+        if ((out[i][0] & 0xF0) != 0x90 || out[i][2] == 0) continue;
+        if (chan >= 0 && (out[i][0] & 0x0F) != chan) continue;
+        sig = sig * 131u + out[i][1] + 1u;
+    }
+    return sig;
+}
+
+static void run(midi_fx_api_v1_t *api, void *inst, int from, int to, uint32_t *sig) {
+    uint8_t out[64][3];
+    int lens[64];
+    int t;
+    for (t = from; t < to; t++) {
+        int n = api->tick(inst, BLOCK, SAMPLE_RATE, out, lens, 64);
+        sig[t] = block_sig(out, n, -1);
+    }
+}
+
+/* Two parts with identical lanes and seeds must still evolve independently. */
+static void test_parts_evolve_independently(midi_fx_api_v1_t *api) {
+    void *inst = make_instance(api, "70", "8");
+    uint8_t out[64][3];
+    int lens[64];
+    int diff = 0;
+    int t;
+    api->set_param(inst, "parts", "2");
+    api->set_param(inst, "part2_lane1_steps", "8");
+    api->set_param(inst, "part2_lane1_pulses", "3");
+    api->set_param(inst, "part2_lane1_n_rnd", "60");
+    api->set_param(inst, "part2_lane2_enabled", "on");
+    api->set_param(inst, "part2_lane2_steps", "5");
+    api->set_param(inst, "part2_lane2_pulses", "2");
+    api->set_param(inst, "part2_part_chan", "2");
+    api->set_param(inst, "part1_part_chan", "1");
+    for (t = 0; t < BLOCKS; t++) {
+        int n = api->tick(inst, BLOCK, SAMPLE_RATE, out, lens, 64);
+        diff += block_sig(out, n, 0) != block_sig(out, n, 1);
+    }
+    api->destroy_instance(inst);
+    if (diff == 0) fail("parts share their evolve mutations");
+}
+
+/* Drops an instance 10^6 one-step cycles into the set: deriving the evolved
+ * lanes must fit in a block. */
+static void test_far_seek_cost(midi_fx_api_v1_t *api) {
+    void *a = make_instance(api, "70", "1");
+    void *b = api->create_instance("", NULL);
+    uint8_t out[64][3];
+    int lens[64];
+    static char state[8192];
+    static char runtime[8192];
+    static uint32_t warm[100];
+    uint64_t anchor = SEEK_CYCLES;
+    uint64_t worst = 0;
+    uint64_t budget = 1000000000ull * BLOCK / SAMPLE_RATE;
+    int i;
+    run(api, a, 0, 100, warm);
+    api->get_param(a, "state", state, (int)sizeof(state));
+    api->get_param(a, "runtime_state", runtime, (int)sizeof(runtime));
+    /* Blob bytes 10-17 hold the little-endian anchor step, 18-25 the phrase
+     * anchor. */
+    for (i = 0; i < 16; i++) {
+        unsigned byte = i < 8 ? (unsigned)(anchor >> (8 * i)) & 0xFFu : 0u;
+        runtime[20 + i * 2] = "0123456789abcdef"[byte >> 4];
+        runtime[21 + i * 2] = "0123456789abcdef"[byte & 0x0F];
+    }
+    api->set_param(b, "state", state);
+    api->set_param(b, "runtime_state", runtime);
+    api->get_param(b, "runtime_state", state, (int)sizeof(state));
+    if (strncmp(state + 20, runtime + 20, 32) != 0) fail("seek blob was not imported");
+    for (i = 0; i < 200; i++) {
+        uint64_t t0 = now_ns();
+        (void)api->tick(b, BLOCK, SAMPLE_RATE, out, lens, 64);
+        t0 = now_ns() - t0;
+        if (t0 > worst) worst = t0;
+    }
+    api->destroy_instance(a);
+    api->destroy_instance(b);
+    if (worst > budget) {
+        fprintf(stderr, "worst tick %llu ns, budget %llu ns\n", (unsigned long long)worst,
+                (unsigned long long)budget);
+        fail("far seek exceeds the block budget");
+    }
+}
+
+int main(void) {
+    host_api_v1_t host;
+    midi_fx_api_v1_t *api;
+    static uint32_t plain[BLOCKS];
+    static uint32_t evolved[BLOCKS];
+    static uint32_t again[BLOCKS];
+    static uint32_t resumed[BLOCKS];
+    static uint32_t walked[WALK_BLOCKS];
+    static uint32_t seeked[WALK_BLOCKS];
+    static char state[8192];
+    static char runtime[8192];
+    char buf[32];
+    void *a;
+    void *b;
+    int diff = 0;
+    int t;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+    api = move_midi_fx_init(&host);
+    if (!api) fail("eucalypso API init failed");
+
+    a = make_instance(api, "0", "8");
+    run(api, a, 0, BLOCKS, plain);
+    api->destroy_instance(a);
+
+    a = make_instance(api, "70", "8");
+    run(api, a, 0, BLOCKS, evolved);
+    api->destroy_instance(a);
+    for (t = 0; t < BLOCKS; t++) diff += plain[t] != evolved[t];
+    if (diff == 0) fail("evolve changes the pattern");
+
+    a = make_instance(api, "70", "8");
+    run(api, a, 0, BLOCKS, again);
+    api->destroy_instance(a);
+    if (memcmp(evolved, again, sizeof(again)) != 0) fail("evolve is deterministic");
+
+    /* A fresh instance dropped into the middle of the set plays the same
+     * cycles without having seen the earlier ones. */
+    a = make_instance(api, "70", "8");
+    run(api, a, 0, HANDOFF_BLOCK, resumed);
+    api->get_param(a, "state", state, (int)sizeof(state));
+    api->get_param(a, "runtime_state", runtime, (int)sizeof(runtime));
+    b = api->create_instance("", NULL);
+    api->set_param(b, "state", state);
+    api->set_param(b, "runtime_state", runtime);
+    run(api, b, HANDOFF_BLOCK, BLOCKS, resumed);
+    if (memcmp(evolved + HANDOFF_BLOCK, resumed + HANDOFF_BLOCK,
+               sizeof(uint32_t) * (BLOCKS - HANDOFF_BLOCK)) != 0) {
+        fail("evolve is seekable from the cycle count");
+    }
+    api->get_param(b, "evolve", buf, (int)sizeof(buf));
+    if (strcmp(buf, "70") != 0) fail("evolve round trip");
+    api->get_param(b, "evolve_seed", buf, (int)sizeof(buf));
+    if (strcmp(buf, "321") != 0) fail("evolve_seed round trip");
+    api->destroy_instance(a);
+    api->destroy_instance(b);
+
+    /* Doubling lane 1's step count halves its cycle number; it must land
+     * where a lane that always had the longer cycle stands. */
+    a = make_instance(api, "70", "2");
+    run(api, a, 0, WALK_BLOCKS, walked);
+    api->destroy_instance(a);
+    a = make_instance(api, "70", "1");
+    run(api, a, 0, SEEK_BLOCK, seeked);
+    api->set_param(a, "lane1_steps", "2");
+    api->set_param(a, "lane1_pulses", "3");
+    run(api, a, SEEK_BLOCK, WALK_BLOCKS, seeked);
+    api->destroy_instance(a);
+    if (memcmp(walked + SEEK_BLOCK, seeked + SEEK_BLOCK, sizeof(uint32_t) * (WALK_BLOCKS - SEEK_BLOCK)) != 0) {
+        fail("evolve follows a changed step count");
+    }
+
+    test_parts_evolve_independently(api);
+    test_far_seek_cost(api);
+
+    printf("PASS: eucalypso evolve mode\n");
+    return 0;
+}
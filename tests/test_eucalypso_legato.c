@@ -0,0 +1,148 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+#define SAMPLE_RATE 48000
+#define STEP_SAMPLES 6000
+#define MAX_EVENTS 32
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_STOPPED;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+typedef struct {
+    long on[MAX_EVENTS];
+    long off[MAX_EVENTS];
+    int ons;
+    int offs;
+} note_times_t;
+
+/* E(3,8) on held note 60 at 120 BPM 1/16, legato on, for 16 steps. */
+static void run(midi_fx_api_v1_t *api, const char *gate, const char *dir, note_times_t *t) {
+    void *inst = api->create_instance("", NULL);
+    uint8_t out[16][3];
+    int lens[16];
+    uint8_t held[3] = { 0x90, 60, 100 };
+    uint8_t start[1] = { 0xFA };
+    long sample;
+    int i;
+
+    memset(t, 0, sizeof(*t));
+    api->set_param(inst, "lane1_steps", "8");
+    api->set_param(inst, "lane1_pulses", "3");
+    api->set_param(inst, "lane1_legato", "on");
+    api->set_param(inst, "lane1_dir", dir);
+    api->set_param(inst, "global_gate", gate);
+    api->process_midi(inst, held, 3, out, lens, 16);
+    api->process_midi(inst, start, 1, out, lens, 16);
+    for (sample = 0; sample < STEP_SAMPLES * 16; sample++) {
+        int n = api->tick(inst, 1, SAMPLE_RATE, out, lens, 16);
+        for (i = 0; i < n; i++) {
+            int on = (out[i][0] & 0xF0) == 0x90 && out[i][2] > 0;
+            if (on && t->ons < MAX_EVENTS) t->on[t->ons++] = sample;
+            else if (!on && t->offs < MAX_EVENTS) t->off[t->offs++] = sample;
+        }
+    }
+    api->destroy_instance(inst);
+}
+
+static int near(long got, long want) {
+    return labs(got - want) <= 1;
+}
+
+/* Hits at steps first + k * 8 + {0, 3, 6} (E(3,8) is x..x..x.), each held
+ * for pct percent of the distance to the next one. */
+static void check(const note_times_t *t, int first, int pct, const char *msg) {
+    static const int hit_pos[3] = { 0, 3, 6 };
+    static const int to_next[3] = { 3, 3, 2 };
+    int k;
+    if (t->ons < 6 || t->offs < 5) fail(msg);
+    for (k = 0; k < 5; k++) {
+        long step = first + (k / 3) * 8 + hit_pos[k % 3];
+        long len = (long)to_next[k % 3] * STEP_SAMPLES * pct / 100;
+        if (!near(t->on[k], step * STEP_SAMPLES) || !near(t->off[k] - t->on[k], len)) {
+            fprintf(stderr, "hit %d: on %ld off %ld\n", k, t->on[k], t->off[k]);
+            fail(msg);
+        }
+    }
+}
+
+/* A 128-step pingpong lane with one pulse hits every 254 steps; at a 1000%
+ * gate its note must last the full 2540 steps. Pulses drop to 0 after the
+ * first hit so no retrigger cuts the note short. */
+static void test_long_pingpong_gate(midi_fx_api_v1_t *api) {
+    void *inst = api->create_instance("", NULL);
+    uint8_t out[16][3];
+    uint8_t held[3] = { 0x90, 60, 100 };
+    uint8_t start[1] = { 0xFA };
+    int lens[16];
+    long block;
+    long off = -1;
+    int i;
+
+    api->set_param(inst, "lane1_steps", "128");
+    api->set_param(inst, "lane1_pulses", "1");
+    api->set_param(inst, "lane1_legato", "on");
+    api->set_param(inst, "lane1_dir", "pingpong");
+    api->set_param(inst, "global_gate", "1000");
+    api->process_midi(inst, held, 3, out, lens, 16);
+    api->process_midi(inst, start, 1, out, lens, 16);
+    for (block = 0; block < (long)STEP_SAMPLES * 2600 / 64 && off < 0; block++) {
+        int n = api->tick(inst, 64, SAMPLE_RATE, out, lens, 16);
+        if (block == 1) api->set_param(inst, "lane1_pulses", "0");
+        for (i = 0; i < n; i++) {
+            if ((out[i][0] & 0xF0) == 0x80 || ((out[i][0] & 0xF0) == 0x90 && out[i][2] == 0)) off = block * 64;
+        }
+    }
+    api->destroy_instance(inst);
+    if (labs(off - 2540L * STEP_SAMPLES) > 64) {
+        fprintf(stderr, "note off at sample %ld\n", off);
+        fail("legato gate spans a whole pingpong period");
+    }
+}
+
+int main(void) {
+    host_api_v1_t host;
+    midi_fx_api_v1_t *api;
+    note_times_t t;
+    void *inst;
+    char buf[4096];
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+    api = move_midi_fx_init(&host);
+    if (api == NULL) fail("api init");
+
+    run(api, "100", "fwd", &t);
+    check(&t, 0, 100, "legato holds until the next hit");
+    run(api, "50", "fwd", &t);
+    check(&t, 0, 50, "legato scales by the gate percentage");
+    /* Reversed, position 0 of each cycle is read on step 7, so hits land on
+     * steps 1, 4, 7 with the same 3, 3, 2 spacing. */
+    run(api, "100", "rev", &t);
+    check(&t, 1, 100, "legato follows the lane direction");
+
+    inst = api->create_instance("", NULL);
+    api->set_param(inst, "lane2_legato", "on");
+    api->get_param(inst, "state", buf, (int)sizeof(buf));
+    if (strstr(buf, "\"lane2_legato\":\"on\"") == NULL) fail("lane legato in state");
+    if (strstr(buf, "\"lane1_legato\":\"off\"") == NULL) fail("legato defaults off");
+    api->destroy_instance(inst);
+
+    test_long_pingpong_gate(api);
+
+    printf("PASS: eucalypso legato\n");
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+#define SAMPLE_RATE 48000
+#define TRIGGER_SAMPLES 4800
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_STOPPED;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+static int count_note_ons(uint8_t out[][3], int n, int note) {
+    int i;
+    int ons = 0;
+    for (i = 0; i < n; i++) {
+        if ((out[i][0] & 0xF0) == 0x90 && out[i][2] > 0 && out[i][1] == note) ons++;
+    }
+    return ons;
+}
+
+static int count_note_offs(uint8_t out[][3], int n, int note) {
+    int i;
+    int offs = 0;
+    for (i = 0; i < n; i++) {
+        int off = (out[i][0] & 0xF0) == 0x80 || ((out[i][0] & 0xF0) == 0x90 && out[i][2] == 0);
+        if (off && out[i][1] == note) offs++;
+    }
+    return offs;
+}
+
+/* Runs one-frame ticks until the held note 60 is released; returns the
+ * number of frames it took, or -1 if it never was. */
+static long frames_until_off(midi_fx_api_v1_t *api, void *inst, long limit) {
+    uint8_t out[16][3];
+    int lens[16];
+    long f;
+    for (f = 1; f <= limit; f++) {
+        int n = api->tick(inst, 1, SAMPLE_RATE, out, lens, 16);
+        if (count_note_offs(out, n, 60) > 0) return f;
+    }
+    return -1;
+}
+
+int main(void) {
+    host_api_v1_t host;
+    midi_fx_api_v1_t *api;
+    void *inst;
+    uint8_t out[16][3];
+    int lens[16];
+    uint8_t held[3] = { 0x90, 60, 100 };
+    uint8_t trig_on[3] = { 0x90, 36, 100 };
+    uint8_t trig_off[3] = { 0x80, 36, 0 };
+    uint8_t trig_ch2[3] = { 0x91, 36, 100 };
+    char buf[4096];
+    long off_at;
+    int n;
+    int k;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+    api = move_midi_fx_init(&host);
+    if (api == NULL) fail("api init");
+
+    inst = api->create_instance("", NULL);
+    api->set_param(inst, "sync", "note");
+    api->set_param(inst, "lane1_steps", "2");
+    api->set_param(inst, "lane1_pulses", "1");
+    api->set_param(inst, "global_gate", "50");
+    n = api->process_midi(inst, held, 3, out, lens, 16);
+    if (count_note_ons(out, n, 60) != 0) fail("held note is not played by itself");
+
+    /* Without triggers, time alone never advances the pattern. */
+    for (k = 0; k < SAMPLE_RATE; k++) {
+        n = api->tick(inst, 1, SAMPLE_RATE, out, lens, 16);
+        if (count_note_ons(out, n, 60) != 0) fail("no steps without triggers");
+    }
+
+    /* Each trigger is one step, emitted from the same process_midi call:
+     * steps 0 and 2 hit, steps 1 and 3 rest. */
+    for (k = 0; k < 4; k++) {
+        n = api->process_midi(inst, trig_on, 3, out, lens, 16);
+        if (count_note_ons(out, n, 36) != 0) fail("trigger note is consumed");
+        if (count_note_ons(out, n, 60) != ((k % 2) == 0 ? 1 : 0)) fail("trigger emits its step immediately");
+        n = api->process_midi(inst, trig_off, 3, out, lens, 16);
+        if (n != 0) fail("trigger note-off is consumed");
+        off_at = frames_until_off(api, inst, TRIGGER_SAMPLES);
+        if (k == 0 && off_at <= 0) fail("first gate ends");
+        if (k == 2 && labs(off_at - TRIGGER_SAMPLES / 2) > 1) fail("gate follows the measured trigger interval");
+        while (off_at >= 0 && off_at < TRIGGER_SAMPLES) {
+            api->tick(inst, 1, SAMPLE_RATE, out, lens, 16);
+            off_at++;
+        }
+    }
+    /* A channel filter ignores triggers on other channels; they pass
+     * through as ordinary held notes. Step 4 is the next hit only if the
+     * filtered note did not advance the pattern. */
+    api->set_param(inst, "trig_chan", "1");
+    n = api->process_midi(inst, trig_ch2, 3, out, lens, 16);
+    if (count_note_ons(out, n, 60) != 0) fail("other channel does not advance");
+    n = api->process_midi(inst, trig_on, 3, out, lens, 16);
+    if (count_note_ons(out, n, 36) + count_note_ons(out, n, 60) != 1) fail("step 4 hits after the filtered trigger");
+
+    api->get_param(inst, "state", buf, (int)sizeof(buf));
+    if (strstr(buf, "\"sync\":\"note\"") == NULL) fail("sync note in state");
+    if (strstr(buf, "\"trig_note\":36") == NULL) fail("trig_note in state");
+    if (strstr(buf, "\"trig_chan\":\"1\"") == NULL) fail("trig_chan in state");
+    api->destroy_instance(inst);
+
+    inst = api->create_instance("", NULL);
+    api->set_param(inst, "state", "{\"sync\":\"note\",\"trig_note\":200,\"trig_chan\":\"any\"}");
+    api->get_param(inst, "sync", buf, (int)sizeof(buf));
+    if (strcmp(buf, "note") != 0) fail("sync restored");
+    api->get_param(inst, "trig_note", buf, (int)sizeof(buf));
+    if (strcmp(buf, "127") != 0) fail("trig_note clamps");
+    api->get_param(inst, "trig_chan", buf, (int)sizeof(buf));
+    if (strcmp(buf, "any") != 0) fail("trig_chan restored");
+    api->destroy_instance(inst);
+
+    printf("PASS: eucalypso note clock\n");
+    return 0;
+}
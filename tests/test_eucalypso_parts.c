@@ -0,0 +1,143 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+static midi_fx_api_v1_t *g_api;
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_STOPPED;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+static void expect_param(void *inst, const char *key, const char *want) {
+    char buf[64];
+    char msg[128];
+    int n = g_api->get_param(inst, key, buf, (int)sizeof(buf));
+    snprintf(msg, sizeof(msg), "%s == %s (got %s)", key, want, n >= 0 ? buf : "<none>");
+    if (n < 0 || strcmp(buf, want) != 0) fail(msg);
+}
+
+/* Two note-clocked parts with a one-step lane each, holding C4. */
+static void *make(void) {
+    void *inst = g_api->create_instance("", NULL);
+    uint8_t out[16][3];
+    int lens[16];
+    uint8_t held[3] = { 0x90, 60, 100 };
+    g_api->set_param(inst, "sync", "note");
+    g_api->set_param(inst, "global_gate", "50");
+    g_api->set_param(inst, "parts", "2");
+    g_api->set_param(inst, "lane1_steps", "1");
+    g_api->set_param(inst, "lane1_pulses", "1");
+    g_api->set_param(inst, "part2_lane1_steps", "1");
+    g_api->set_param(inst, "part2_lane1_pulses", "1");
+    g_api->process_midi(inst, held, 3, out, lens, 16);
+    return inst;
+}
+
+/* One trigger; records the note sent on each 1-based channel (0 = none). */
+static int step(void *inst, int *note_on_chan) {
+    uint8_t out[16][3];
+    int lens[16];
+    uint8_t trig[3] = { 0x90, 36, 100 };
+    int n = g_api->process_midi(inst, trig, 3, out, lens, 16);
+    int ons = 0;
+    int i;
+    memset(note_on_chan, 0, sizeof(int) * 17);
+    for (i = 0; i < n; i++) {
+        if ((out[i][0] & 0xF0) == 0x90 && out[i][2] > 0) {
+            note_on_chan[(out[i][0] & 0x0F) + 1] = out[i][1];
+            ons++;
+        }
+    }
+    return ons;
+}
+
+int main(void) {
+    host_api_v1_t host;
+    int chans[17];
+    char state[16384];
+    void *inst;
+    void *copy;
+    int ons;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+    g_api = move_midi_fx_init(&host);
+    if (g_api == NULL) fail("api init");
+
+    /* A single part saves no part keys. */
+    inst = g_api->create_instance("", NULL);
+    expect_param(inst, "parts", "1");
+    expect_param(inst, "part_chan", "auto");
+    expect_param(inst, "part2_part_chan", "2");
+    if (g_api->get_param(inst, "state", state, (int)sizeof(state)) <= 0) fail("single part state");
+    if (strstr(state, "\"part2_") != NULL) fail("single part state has no part2 keys");
+    g_api->destroy_instance(inst);
+
+    /* Both parts play the same held pitch on their own channel; neither
+     * kills the other. */
+    inst = make();
+    g_api->set_param(inst, "part2_part_chan", "2");
+    ons = step(inst, chans);
+    if (ons != 2 || chans[1] != 60 || chans[2] != 60) fail("both parts play on their channels");
+    ons = step(inst, chans);
+    if (ons != 2 || chans[1] != 60 || chans[2] != 60) fail("same pitch does not cut across parts");
+
+    /* Part 2 takes its own register and lane settings. */
+    g_api->set_param(inst, "part2_register_mode", "scale");
+    g_api->set_param(inst, "part2_root_note", "2");
+    g_api->set_param(inst, "part2_lane1_octave", "1");
+    expect_param(inst, "register_mode", "held");
+    expect_param(inst, "part2_register_mode", "scale");
+    expect_param(inst, "lane1_octave", "0");
+    expect_param(inst, "part2_lane1_octave", "1");
+    ons = step(inst, chans);
+    if (ons != 2 || chans[1] != 60 || chans[2] == 0 || chans[2] == 60) fail("part 2 follows its own register");
+
+    /* Unprefixed keys address the part selected for editing. */
+    g_api->set_param(inst, "part", "2");
+    expect_param(inst, "register_mode", "scale");
+    g_api->set_param(inst, "lane1_velocity", "77");
+    expect_param(inst, "part2_lane1_velocity", "77");
+    g_api->set_param(inst, "part", "1");
+    expect_param(inst, "lane1_velocity", "0");
+
+    /* Extra parts survive a state round-trip; out of range parts do not
+     * exist. */
+    g_api->set_param(inst, "part", "2");
+    if (g_api->get_param(inst, "state", state, (int)sizeof(state)) <= 0) fail("state");
+    if (strstr(state, "\"part2_register_mode\":\"scale\"") == NULL) fail("state carries part 2 register");
+    if (strstr(state, "\"part2_lane1_velocity\":77") == NULL) fail("state carries part 2 lanes");
+    if (strstr(state, "\"part3_") != NULL) fail("state omits unused parts");
+    copy = g_api->create_instance("", NULL);
+    g_api->set_param(copy, "state", state);
+    expect_param(copy, "parts", "2");
+    expect_param(copy, "part", "2");
+    expect_param(copy, "part2_register_mode", "scale");
+    expect_param(copy, "part2_root_note", "2");
+    expect_param(copy, "part2_part_chan", "2");
+    expect_param(copy, "part2_lane1_velocity", "77");
+    expect_param(copy, "part1_register_mode", "held");
+    if (g_api->get_param(copy, "part5_register_mode", state, (int)sizeof(state)) >= 0) fail("part 5 is rejected");
+    g_api->destroy_instance(copy);
+
+    /* Dropping back to one part silences part 2. */
+    g_api->set_param(inst, "parts", "1");
+    ons = step(inst, chans);
+    if (ons != 1 || chans[1] != 60 || chans[2] != 0) fail("one part plays alone");
+    g_api->destroy_instance(inst);
+
+    printf("PASS: eucalypso parts\n");
+    return 0;
+}
@@ -0,0 +1,180 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+#define SAMPLE_RATE 48000
+#define STEP_SAMPLES 6000
+
+/* Layout documented in README "Shared Playhead". */
+typedef struct {
+    uint64_t mask[2];
+    uint16_t steps;
+    uint16_t position;
+    uint8_t enabled;
+    uint8_t hit;
+    uint8_t last_note;
+    uint8_t last_velocity;
+    uint32_t reserved[2];
+} ui_lane_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t lane_count;
+    uint32_t seq;
+    uint32_t running;
+    uint64_t anchor_step;
+    uint64_t flick_clock;
+    ui_lane_t lanes[4];
+} ui_playhead_t;
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_STOPPED;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+/* Seqlock read as a UI would do it. */
+static void read_playhead(const volatile ui_playhead_t *ph, ui_playhead_t *out) {
+    uint32_t a;
+    uint32_t b;
+    do {
+        a = __atomic_load_n(&ph->seq, __ATOMIC_ACQUIRE);
+        memcpy(out, (const void *)ph, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        b = __atomic_load_n(&ph->seq, __ATOMIC_RELAXED);
+    } while ((a & 1u) || a != b);
+}
+
+int main(void) {
+    host_api_v1_t host;
+    midi_fx_api_v1_t *api;
+    void *inst;
+    uint8_t out[16][3];
+    int lens[16];
+    uint8_t held[2][3] = { { 0x90, 60, 100 }, { 0x90, 64, 100 } };
+    uint8_t start[1] = { 0xFA };
+    uint8_t stop[1] = { 0xFC };
+    char name[64];
+    char path[96];
+    char name2[80];
+    char path2[112];
+    char buf[256];
+    const volatile ui_playhead_t *ph;
+    const volatile ui_playhead_t *ph2;
+    ui_playhead_t snap;
+    uint32_t seq_before;
+    int fd;
+    int k;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+    api = move_midi_fx_init(&host);
+    if (api == NULL) fail("api init");
+
+    snprintf(name, sizeof(name), "eucalypso-test-%d", (int)getpid());
+    snprintf(path, sizeof(path), "/dev/shm/%s", name);
+
+    inst = api->create_instance("", NULL);
+    api->set_param(inst, "playhead_shm", "../escape");
+    api->get_param(inst, "playhead_shm", buf, (int)sizeof(buf));
+    if (buf[0] != '\0') fail("names with a slash are refused");
+
+    api->set_param(inst, "lane1_steps", "8");
+    api->set_param(inst, "lane1_pulses", "3");
+    api->set_param(inst, "lane2_enabled", "on");
+    api->set_param(inst, "lane2_steps", "4");
+    api->set_param(inst, "lane2_pulses", "1");
+    api->set_param(inst, "lane2_dir", "rev");
+    api->set_param(inst, "playhead_shm", name);
+    api->get_param(inst, "playhead_shm", buf, (int)sizeof(buf));
+    if (strcmp(buf, name) != 0) fail("playhead_shm reports its name");
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) fail("playhead file exists");
+    ph = (const volatile ui_playhead_t *)mmap(NULL, sizeof(ui_playhead_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ph == MAP_FAILED) fail("playhead maps");
+
+    /* set_param writes only the header; the audio thread fills in the rest
+     * on its next tick, even with the transport stopped. */
+    read_playhead(ph, &snap);
+    if (snap.magic != 0x48505545u || snap.lanes[0].steps != 0) fail("UI thread writes only the header");
+    api->tick(inst, 0, SAMPLE_RATE, out, lens, 16);
+    read_playhead(ph, &snap);
+    if (snap.magic != 0x48505545u || snap.version != 1 || snap.lane_count != 4) fail("playhead header");
+    if (snap.lanes[0].steps != 8 || snap.lanes[0].mask[0] != 0x49u) fail("lane 1 mask x..x..x.");
+    if (snap.lanes[1].steps != 4 || snap.lanes[1].mask[0] != 0x1u) fail("lane 2 mask");
+    if (snap.lanes[2].enabled != 0) fail("lane 3 disabled");
+
+    api->process_midi(inst, held[0], 3, out, lens, 16);
+    api->process_midi(inst, held[1], 3, out, lens, 16);
+    api->process_midi(inst, start, 1, out, lens, 16);
+    for (k = 0; k < 4; k++) {
+        seq_before = snap.seq;
+        api->tick(inst, k == 0 ? 1 : STEP_SAMPLES, SAMPLE_RATE, out, lens, 16);
+        read_playhead(ph, &snap);
+        if (snap.seq != seq_before + 2) fail("one publish per step");
+        if (snap.anchor_step != (uint64_t)k + 1) fail("anchor follows the step");
+        if (snap.lanes[0].position != k) fail("lane 1 position");
+        if (snap.lanes[1].position != 3 - k) fail("reversed lane position");
+        if (!(snap.lanes[0].hit == (k == 0 || k == 3))) fail("lane 1 hits on its mask");
+        if (!(snap.lanes[1].hit == (k == 3))) fail("lane 2 hits when it reads position 0");
+    }
+    if (snap.lanes[0].last_note != 60 || snap.lanes[0].last_velocity != 100) fail("last note and velocity");
+    if (snap.lanes[1].last_note != 64) fail("lane 2 last note");
+    if (snap.running != 1) fail("running");
+
+    /* Remapping while running moves publishing to the new file, which gets
+     * every mask even though none changed. */
+    snprintf(name2, sizeof(name2), "%s-b", name);
+    snprintf(path2, sizeof(path2), "/dev/shm/%s", name2);
+    api->set_param(inst, "playhead_shm", name2);
+    fd = open(path2, O_RDONLY);
+    if (fd < 0) fail("second playhead file exists");
+    ph2 = (const volatile ui_playhead_t *)mmap(NULL, sizeof(ui_playhead_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ph2 == MAP_FAILED) fail("second playhead maps");
+    seq_before = ph->seq;
+    api->tick(inst, STEP_SAMPLES, SAMPLE_RATE, out, lens, 16);
+    if (ph->seq != seq_before) fail("old mapping is left alone after a remap");
+    read_playhead(ph2, &snap);
+    if (snap.anchor_step != 5 || snap.lanes[0].position != 4) fail("remapped playhead follows the step");
+    if (snap.lanes[0].mask[0] != 0x49u || snap.lanes[1].mask[0] != 0x1u) fail("remapped playhead has the masks");
+    munmap((void *)ph2, sizeof(ui_playhead_t));
+    unlink(path2);
+    api->set_param(inst, "playhead_shm", name);
+
+    api->process_midi(inst, stop, 1, out, lens, 16);
+    read_playhead(ph, &snap);
+    if (snap.anchor_step != 0) fail("stop rewinds the published position");
+
+    api->set_param(inst, "playhead_shm", "off");
+    api->get_param(inst, "playhead_shm", buf, (int)sizeof(buf));
+    if (buf[0] != '\0') fail("playhead unmapped");
+    seq_before = ph->seq;
+    api->tick(inst, STEP_SAMPLES * 2, SAMPLE_RATE, out, lens, 16);
+    if (ph->seq != seq_before) fail("no publish after unmap");
+
+    api->destroy_instance(inst);
+    munmap((void *)ph, sizeof(ui_playhead_t));
+    unlink(path);
+
+    printf("PASS: eucalypso playhead\n");
+    return 0;
+}
@@ -0,0 +1,106 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+#include "eucalypso_test_presets.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_STOPPED;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    host_api_v1_t host;
+    midi_fx_api_v1_t *api;
+    void *src;
+    void *dst;
+    char buf[4096];
+    char state_a[8192];
+    char state_b[8192];
+    char state_dst[8192];
+    test_preset_t presets[2];
+    test_library_t lib;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+    api = move_midi_fx_init(&host);
+    if (api == NULL) fail("api init");
+
+    src = api->create_instance("", NULL);
+    dst = api->create_instance("", NULL);
+    if (!src || !dst) fail("create instances");
+
+    api->set_param(src, "rate", "1/8");
+    api->set_param(src, "scale_mode", "dorian");
+    api->set_param(src, "lane2_enabled", "on");
+    api->set_param(src, "lane2_pulses", "5");
+    api->set_param(src, "lane3_octave", "-2");
+    api->set_param(src, "rng_version", "2");
+    api->set_param(src, "evolve", "40");
+    api->set_param(src, "evolve_seed", "9");
+    api->set_param(src, "chan_mode", "rr");
+    api->set_param(src, "chan_lo", "3");
+    api->set_param(src, "lane2_dir", "pingpong");
+    api->set_param(src, "lane2_dir_seed", "11");
+    api->set_param(src, "lane3_legato", "on");
+    api->set_param(src, "lane1_early_ms", "5");
+    api->get_param(src, "state", state_a, (int)sizeof(state_a));
+
+    api->set_param(src, "rate", "1/16T");
+    api->set_param(src, "play_mode", "latch");
+    api->set_param(src, "sync", "clock");
+    api->set_param(src, "lane1_steps", "7");
+    api->set_param(src, "lane4_gate", "300");
+    api->get_param(src, "state", state_b, (int)sizeof(state_b));
+
+    /* Packed out of name order; the index sorts "Bright Pulse" to slot 0. */
+    presets[0].name = "Dark Drift";
+    presets[0].tags = "slow";
+    presets[0].state = state_a;
+    presets[1].name = "Bright Pulse";
+    presets[1].tags = "fast,major";
+    presets[1].state = state_b;
+    if (argc < 2 || !test_library_pack(&lib, argv[1], presets, 2)) fail("pack library");
+
+    api->set_param(dst, "preset_lib", lib.path);
+    api->get_param(dst, "preset_count", buf, (int)sizeof(buf));
+    if (strcmp(buf, "2") != 0) fail("preset_count");
+    api->get_param(dst, "preset_name_0", buf, (int)sizeof(buf));
+    if (strcmp(buf, "Bright Pulse") != 0) fail("preset_name_0");
+    api->get_param(dst, "preset_tags_0", buf, (int)sizeof(buf));
+    if (strcmp(buf, "fast,major") != 0) fail("preset_tags_0");
+    if (api->get_param(dst, "preset_name_2", buf, (int)sizeof(buf)) >= 0) fail("preset_name out of range");
+
+    api->set_param(dst, "preset_load", "Dark Drift");
+    api->get_param(dst, "state", state_dst, (int)sizeof(state_dst));
+    if (strcmp(state_dst, state_a) != 0) fail("load by name restores state");
+    api->get_param(dst, "preset_load", buf, (int)sizeof(buf));
+    if (strcmp(buf, "Dark Drift") != 0) fail("current preset name");
+
+    api->set_param(dst, "preset_slot", "0");
+    api->get_param(dst, "state", state_dst, (int)sizeof(state_dst));
+    if (strcmp(state_dst, state_b) != 0) fail("load by slot restores state");
+
+    api->set_param(dst, "preset_load", "Missing");
+    api->get_param(dst, "state", state_dst, (int)sizeof(state_dst));
+    if (strcmp(state_dst, state_b) != 0) fail("unknown name leaves state untouched");
+
+    api->destroy_instance(src);
+    api->destroy_instance(dst);
+    test_library_remove(&lib);
+
+    printf("PASS: eucalypso preset library\n");
+    return 0;
+}
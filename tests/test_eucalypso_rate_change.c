@@ -0,0 +1,93 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+#define MAX_EVENTS 64
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_STOPPED;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+/* Sample rate in effect at a given time; switches while a gate is open. */
+static int rate_at(double t) {
+    if (t < 0.30) return 44100;
+    if (t < 0.71) return 48000;
+    if (t < 1.10) return 96000;
+    return 22050;
+}
+
+int main(void) {
+    host_api_v1_t host;
+    midi_fx_api_v1_t *api;
+    void *inst;
+    uint8_t out[16][3];
+    int lens[16];
+    uint8_t note_on[3] = { 0x90, 60, 100 };
+    uint8_t start[1] = { 0xFA };
+    double on_at[MAX_EVENTS];
+    double off_at[MAX_EVENTS];
+    int ons = 0;
+    int offs = 0;
+    double t = 0.0;
+    int k;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+    api = move_midi_fx_init(&host);
+    if (api == NULL) fail("api init");
+
+    inst = api->create_instance("", NULL);
+    api->set_param(inst, "lane1_steps", "1");
+    api->set_param(inst, "lane1_pulses", "1");
+    api->set_param(inst, "global_gate", "50");
+    api->process_midi(inst, note_on, 3, out, lens, 16);
+    api->process_midi(inst, start, 1, out, lens, 16);
+
+    /* One-frame blocks: every event is observed on the frame it lands in. */
+    while (t < 1.6) {
+        int rate = rate_at(t);
+        int n = api->tick(inst, 1, rate, out, lens, 16);
+        int i;
+        for (i = 0; i < n; i++) {
+            int on = (out[i][0] & 0xF0) == 0x90 && out[i][2] > 0;
+            if (on && ons < MAX_EVENTS) on_at[ons++] = t;
+            else if (!on && offs < MAX_EVENTS) off_at[offs++] = t;
+        }
+        t += 1.0 / (double)rate;
+    }
+    api->destroy_instance(inst);
+
+    /* 120 BPM at 1/16: a step every 125 ms with a 62.5 ms gate. */
+    if (ons != 13) fail("step count across rate changes");
+    if (offs < 12) fail("gate count across rate changes");
+    for (k = 0; k < ons; k++) {
+        double ref = (double)k * 0.125;
+        if (fabs(on_at[k] - ref) > 1.0 / 22050.0) {
+            fprintf(stderr, "step %d at %.6f, expected %.6f\n", k, on_at[k], ref);
+            fail("step phase preserved");
+        }
+    }
+    for (k = 0; k < offs; k++) {
+        double ref = (double)k * 0.125 + 0.0625;
+        if (fabs(off_at[k] - ref) > 1.0 / 22050.0) {
+            fprintf(stderr, "gate %d ends at %.6f, expected %.6f\n", k, off_at[k], ref);
+            fail("gate length preserved");
+        }
+    }
+
+    printf("PASS: eucalypso sample-rate changes\n");
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+#define STEPS 2000
+
+static midi_fx_api_v1_t *g_api;
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_STOPPED;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+/* A one-step lane over a three-note chord, clocked by trigger notes so
+ * every step's output is returned directly. */
+static void *make(const char *rng_version, const char *n_seed) {
+    void *inst = g_api->create_instance("", NULL);
+    uint8_t out[16][3];
+    int lens[16];
+    uint8_t chord[3][3] = { { 0x90, 60, 100 }, { 0x90, 64, 100 }, { 0x90, 67, 100 } };
+    int i;
+    g_api->set_param(inst, "rng_version", rng_version);
+    g_api->set_param(inst, "sync", "note");
+    g_api->set_param(inst, "rand_cycle", "128");
+    g_api->set_param(inst, "lane1_steps", "1");
+    g_api->set_param(inst, "lane1_pulses", "1");
+    g_api->set_param(inst, "lane1_drop", "50");
+    g_api->set_param(inst, "lane1_drop_seed", "11");
+    g_api->set_param(inst, "lane1_n_rnd", "100");
+    g_api->set_param(inst, "lane1_n_seed", n_seed);
+    g_api->set_param(inst, "global_v_rnd", "20");
+    for (i = 0; i < 3; i++) g_api->process_midi(inst, chord[i], 3, out, lens, 16);
+    return inst;
+}
+
+/* notes[i] is the note played on step i, or -1 when the step dropped;
+ * velocities[i] likewise. */
+static void run(void *inst, int *notes, int *velocities) {
+    uint8_t out[16][3];
+    int lens[16];
+    uint8_t trig[3] = { 0x90, 36, 100 };
+    int i;
+    for (i = 0; i < STEPS; i++) {
+        int n = g_api->process_midi(inst, trig, 3, out, lens, 16);
+        int j;
+        notes[i] = -1;
+        velocities[i] = -1;
+        for (j = 0; j < n; j++) {
+            if ((out[j][0] & 0xF0) == 0x90 && out[j][2] > 0) {
+                notes[i] = out[j][1];
+                velocities[i] = out[j][2];
+            }
+        }
+        g_api->tick(inst, 64, 48000, out, lens, 16);
+    }
+}
+
+int main(void) {
+    host_api_v1_t host;
+    static int v1[STEPS];
+    static int v1_vel[STEPS];
+    static int a[STEPS];
+    static int a_vel[STEPS];
+    static int b[STEPS];
+    static int b_vel[STEPS];
+    void *inst;
+    char buf[8192];
+    int played = 0;
+    int counts[3] = { 0, 0, 0 };
+    int same_drops = 1;
+    int i;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+    g_api = move_midi_fx_init(&host);
+    if (g_api == NULL) fail("api init");
+
+    inst = g_api->create_instance("", NULL);
+    g_api->get_param(inst, "rng_version", buf, (int)sizeof(buf));
+    if (strcmp(buf, "1") != 0) fail("new instances default to rng_version 1");
+    g_api->set_param(inst, "rng_version", "9");
+    g_api->get_param(inst, "rng_version", buf, (int)sizeof(buf));
+    if (strcmp(buf, "2") != 0) fail("rng_version clamps");
+    g_api->get_param(inst, "state", buf, (int)sizeof(buf));
+    if (strstr(buf, "\"rng_version\":2") == NULL) fail("rng_version in state");
+    g_api->set_param(inst, "state", "{\"bpm\":120}");
+    g_api->get_param(inst, "rng_version", buf, (int)sizeof(buf));
+    if (strcmp(buf, "1") != 0) fail("state without rng_version loads version 1");
+    g_api->destroy_instance(inst);
+
+    inst = make("1", "5");
+    run(inst, v1, v1_vel);
+    g_api->destroy_instance(inst);
+    inst = make("2", "5");
+    run(inst, a, a_vel);
+    g_api->destroy_instance(inst);
+    inst = make("2", "5");
+    run(inst, b, b_vel);
+    g_api->destroy_instance(inst);
+    if (memcmp(a, b, sizeof(a)) != 0 || memcmp(a_vel, b_vel, sizeof(a_vel)) != 0) fail("version 2 is deterministic");
+    if (memcmp(a, v1, sizeof(a)) == 0) fail("version 2 differs from version 1");
+
+    /* rand_cycle 128 repeats every 128 steps; counts cover whole cycles. */
+    for (i = 0; i < STEPS; i++) {
+        if (a[i] != a[i % 128]) fail("version 2 repeats with rand_cycle");
+        if (a[i] < 0) continue;
+        played++;
+        if (a[i] == 60) counts[0]++;
+        else if (a[i] == 64) counts[1]++;
+        else if (a[i] == 67) counts[2]++;
+        if (a_vel[i] < 80 || a_vel[i] > 120) fail("velocity within v_rnd");
+    }
+    if (played <= STEPS * 2 / 5 || played >= STEPS * 3 / 5) fail("version 2 drop rate near 50%");
+    /* Note 1 (60) is the base; n_rnd 100 always moves to one of the others. */
+    if (counts[0] != 0 || counts[1] <= played / 3 || counts[2] <= played / 3) fail("version 2 note spread");
+
+    /* Each word depends only on its own seed: a new note seed keeps drops. */
+    inst = make("2", "6");
+    run(inst, b, b_vel);
+    g_api->destroy_instance(inst);
+    for (i = 0; i < STEPS; i++) {
+        if ((a[i] < 0) != (b[i] < 0)) same_drops = 0;
+    }
+    if (!same_drops) fail("note seed does not move drops");
+    if (memcmp(a, b, sizeof(a)) == 0) fail("note seed changes notes");
+
+    printf("PASS: eucalypso rng\n");
+    return 0;
+}
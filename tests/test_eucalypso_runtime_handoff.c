@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_RUNNING;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+static void send_midi(midi_fx_api_v1_t *api, void *inst, uint8_t s, uint8_t d1, uint8_t d2) {
+    uint8_t in[3];
+    uint8_t out_msgs[16][3];
+    int out_lens[16];
+    in[0] = s;
+    in[1] = d1;
+    in[2] = d2;
+    (void)api->process_midi(inst, in, 3, out_msgs, out_lens, 16);
+}
+
+static void configure(midi_fx_api_v1_t *api, void *inst, const char *sync, const char *lane1_early_ms) {
+    api->set_param(inst, "sync", sync);
+    api->set_param(inst, "lane1_steps", "16");
+    api->set_param(inst, "lane1_pulses", "7");
+    api->set_param(inst, "lane2_enabled", "on");
+    api->set_param(inst, "lane2_steps", "5");
+    api->set_param(inst, "lane2_pulses", "3");
+    api->set_param(inst, "global_gate", "400");
+    api->set_param(inst, "swing", "30");
+    api->set_param(inst, "retrigger_mode", "restart");
+    api->set_param(inst, "lane1_early_ms", lane1_early_ms);
+}
+
+/* Runs the old instance for warmup blocks, hands its state to a fresh
+ * instance, then checks both produce identical output for run blocks. */
+static void test_handoff(midi_fx_api_v1_t *api, const char *sync, const char *lane1_early_ms, int warmup,
+                         int run) {
+    void *a = api->create_instance(".", NULL);
+    void *b = api->create_instance(".", NULL);
+    uint8_t out_a[64][3];
+    uint8_t out_b[64][3];
+    int lens_a[64];
+    int lens_b[64];
+    static char state[16384];
+    static char runtime[8192];
+    int clock = strcmp(sync, "clock") == 0;
+    int blk;
+    int total_out = 0;
+
+    if (!a || !b) fail("create_instance failed");
+    configure(api, a, sync, lane1_early_ms);
+    (void)api->tick(a, 128, 44100, out_a, lens_a, 64);
+    send_midi(api, a, 0x90, 60, 100);
+    send_midi(api, a, 0x90, 64, 100);
+    send_midi(api, a, 0xFA, 0, 0);
+    for (blk = 0; blk < warmup; blk++) {
+        if (clock && blk % 7 == 0) send_midi(api, a, 0xF8, 0, 0);
+        (void)api->tick(a, 128, 44100, out_a, lens_a, 64);
+    }
+
+    if (api->get_param(a, "state", state, (int)sizeof(state)) <= 0) fail("state export failed");
+    if (api->get_param(a, "runtime_state", runtime, (int)sizeof(runtime)) <= 0) fail("runtime export failed");
+    api->set_param(b, "state", state);
+    api->set_param(b, "runtime_state", runtime);
+
+    for (blk = 0; blk < run; blk++) {
+        int na;
+        int nb;
+        if (clock && blk % 7 == 0) {
+            uint8_t clk[1] = { 0xF8 };
+            na = api->process_midi(a, clk, 1, out_a, lens_a, 64);
+            nb = api->process_midi(b, clk, 1, out_b, lens_b, 64);
+            if (na != nb || memcmp(out_a, out_b, sizeof(out_a[0]) * (size_t)na) != 0) {
+                fail("clock-tick output diverged after handoff");
+            }
+            total_out += na;
+        }
+        na = api->tick(a, 128, 44100, out_a, lens_a, 64);
+        nb = api->tick(b, 128, 44100, out_b, lens_b, 64);
+        if (na != nb || memcmp(out_a, out_b, sizeof(out_a[0]) * (size_t)na) != 0) {
+            fprintf(stderr, "sync=%s block=%d a=%d b=%d\n", sync, blk, na, nb);
+            fail("tick output diverged after handoff");
+        }
+        total_out += na;
+    }
+    if (total_out == 0) fail("expected output after handoff");
+
+    /* A truncated blob must be ignored. */
+    runtime[10] = '\0';
+    api->set_param(b, "runtime_state", runtime);
+
+    api->destroy_instance(a);
+    api->destroy_instance(b);
+}
+
+int main(void) {
+    host_api_v1_t host;
+    midi_fx_api_v1_t *api;
+    int blk;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+
+    api = move_midi_fx_init(&host);
+    if (!api || !api->create_instance || !api->process_midi || !api->tick || !api->destroy_instance) {
+        fail("eucalypso API init/callbacks missing");
+    }
+
+    test_handoff(api, "internal", "0", 517, 3000);
+    test_handoff(api, "clock", "0", 517, 3000);
+    /* Lane 1 plays 20 ms early, so lane 2's notes wait 20 ms in the pending
+     * queue (internal sync); odd steps wait there for swing (clock sync).
+     * Handing off at every block across two step intervals catches notes
+     * queued but not yet sent. */
+    for (blk = 0; blk < 180; blk++) {
+        test_handoff(api, "internal", "20", 440 + blk, 400);
+        test_handoff(api, "clock", "20", 440 + blk, 400);
+    }
+
+    printf("PASS: eucalypso runtime state handoff\n");
+    return 0;
+}
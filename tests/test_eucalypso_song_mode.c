@@ -0,0 +1,145 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+#include "eucalypso_test_presets.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+#define SAMPLE_RATE 48000
+#define BLOCK 500
+#define MAX_HITS 256
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_STOPPED;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+/* Runs the instance for ticks blocks and records the block index and pitch
+ * of every note-on. */
+static int run(midi_fx_api_v1_t *api, void *inst, int ticks, int *at, int *pitch) {
+    uint8_t out[64][3];
+    int lens[64];
+    int hits = 0;
+    int t;
+    for (t = 0; t < ticks; t++) {
+        int n = api->tick(inst, BLOCK, SAMPLE_RATE, out, lens, 64);
+        int i;
+        for (i = 0; i < n; i++) {
+            if ((out[i][0] & 0xF0) == 0x90 && out[i][2] > 0 && hits < MAX_HITS) {
+                at[hits] = t;
+                pitch[hits] = out[i][1];
+                hits++;
+            }
+        }
+    }
+    return hits;
+}
+
+int main(int argc, char **argv) {
+    host_api_v1_t host;
+    midi_fx_api_v1_t *api;
+    void *inst;
+    static char state_a[8192];
+    static char state_b[8192];
+    test_preset_t presets[2];
+    test_library_t lib;
+    uint8_t out[64][3];
+    int lens[64];
+    int at[MAX_HITS];
+    int pitch[MAX_HITS];
+    char buf[256];
+    const uint8_t notes[3] = { 60, 64, 67 };
+    int hits;
+    int i;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+    api = move_midi_fx_init(&host);
+    if (api == NULL) fail("api init");
+
+    /* A: every 1/16 step plays the first note. B: every 1/8 step plays the second. */
+    inst = api->create_instance("", NULL);
+    api->set_param(inst, "lane1_steps", "1");
+    api->set_param(inst, "lane1_pulses", "1");
+    api->set_param(inst, "lane1_note", "1");
+    api->get_param(inst, "state", state_a, (int)sizeof(state_a));
+    api->set_param(inst, "rate", "1/8");
+    api->set_param(inst, "lane1_note", "2");
+    api->get_param(inst, "state", state_b, (int)sizeof(state_b));
+    api->destroy_instance(inst);
+
+    presets[0].name = "A";
+    presets[0].tags = NULL;
+    presets[0].state = state_a;
+    presets[1].name = "B";
+    presets[1].tags = NULL;
+    presets[1].state = state_b;
+    if (argc < 2 || !test_library_pack(&lib, argv[1], presets, 2)) fail("pack library");
+
+    inst = api->create_instance("", NULL);
+    api->set_param(inst, "preset_lib", lib.path);
+    api->set_param(inst, "preset_slot", "0");
+    api->set_param(inst, "song", "0:1:1, 1:1:2");
+    api->set_param(inst, "song_mode", "on");
+    api->get_param(inst, "song", buf, (int)sizeof(buf));
+    if (strcmp(buf, "0:1:1,1:1:2") != 0) fail("song list round trip");
+
+    for (i = 0; i < 3; i++) {
+        uint8_t msg[3] = { 0x90, notes[i], 100 };
+        api->process_midi(inst, msg, 3, out, lens, 64);
+    }
+    {
+        uint8_t start[1] = { 0xFA };
+        api->process_midi(inst, start, 1, out, lens, 64);
+    }
+
+    /* 16 steps of A, then two bars of B (8 steps each at 1/8), then A again. */
+    hits = run(api, inst, 16 * 12 + 16 * 24 + 4 * 12, at, pitch);
+    if (hits < 16 + 16 + 3) fail("enough steps");
+    for (i = 0; i < 16; i++) {
+        if (pitch[i] != 60) fail("section A pitch");
+    }
+    for (i = 16; i < 32; i++) {
+        if (pitch[i] != 64) fail("section B pitch");
+    }
+    for (i = 32; i < 35; i++) {
+        if (pitch[i] != 60) fail("song loops back to A");
+    }
+    if (at[0] != 0) fail("first step on the first block");
+    for (i = 2; i < 16; i++) {
+        if (at[i] - at[i - 1] != 12) fail("section A interval");
+    }
+    if (at[16] - at[15] != 12) fail("boundary step lands on the old grid");
+    for (i = 17; i < 33; i++) {
+        if (at[i] - at[i - 1] != 24) fail("section B interval");
+    }
+    if (at[33] - at[32] != 12) fail("A interval after loop");
+    api->get_param(inst, "song_pos", buf, (int)sizeof(buf));
+    if (strcmp(buf, "0") != 0) fail("song_pos after loop");
+
+    /* A new list set mid-section starts from its first entry on the next
+     * step. */
+    api->set_param(inst, "song", "1:1:1,0:1:1");
+    hits = run(api, inst, 24, at, pitch);
+    if (hits < 1 || pitch[0] != 64) fail("new song list starts at its first entry");
+    api->get_param(inst, "song_pos", buf, (int)sizeof(buf));
+    if (strcmp(buf, "0") != 0) fail("song_pos after a new list");
+
+    api->destroy_instance(inst);
+    test_library_remove(&lib);
+
+    printf("PASS: eucalypso song mode\n");
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+#define SAMPLE_RATE 48000
+#define STEP_FRAMES 6000 /* 1/16 at 120 BPM */
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_STOPPED;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+static void send3(midi_fx_api_v1_t *api, void *inst, uint8_t a, uint8_t b, uint8_t c) {
+    uint8_t msg[3] = { a, b, c };
+    uint8_t out[16][3];
+    int lens[16];
+    api->process_midi(inst, msg, 3, out, lens, 16);
+}
+
+/* One tick per step: returns 1 when the step produced a note-on. */
+static int step_once(midi_fx_api_v1_t *api, void *inst) {
+    uint8_t out[64][3];
+    int lens[64];
+    int n = api->tick(inst, STEP_FRAMES, SAMPLE_RATE, out, lens, 64);
+    int i;
+    for (i = 0; i < n; i++) {
+        if ((out[i][0] & 0xF0) == 0x90 && out[i][2] > 0) return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    host_api_v1_t host;
+    midi_fx_api_v1_t *api;
+    void *inst;
+    char buf[64];
+    int step;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+    api = move_midi_fx_init(&host);
+    if (api == NULL) fail("api init");
+
+    inst = api->create_instance("", NULL);
+    send3(api, inst, 0x90, 60, 100);
+    {
+        uint8_t start[1] = { 0xFA };
+        uint8_t out[16][3];
+        int lens[16];
+        api->process_midi(inst, start, 1, out, lens, 16);
+    }
+    for (step = 0; step < 5; step++) (void)step_once(api, inst);
+
+    api->set_param(inst, "tap_lane", "1");
+    api->get_param(inst, "tap_lane", buf, (int)sizeof(buf));
+    if (strcmp(buf, "1") != 0) fail("tap_lane armed");
+
+    /* Tresillo tapped just after steps 5, 8 and 11. */
+    for (; step < 40; step++) {
+        (void)step_once(api, inst);
+        if (step == 5 || step == 8 || step == 11) {
+            send3(api, inst, 0x90, 48, 100);
+            send3(api, inst, 0x80, 48, 0);
+        }
+    }
+
+    api->get_param(inst, "tap_lane", buf, (int)sizeof(buf));
+    if (strcmp(buf, "off") != 0) fail("capture disarms after the phrase");
+    api->get_param(inst, "tap_fit", buf, (int)sizeof(buf));
+    if (strncmp(buf, "8:3:", 4) != 0) fail("fit steps and pulses");
+    if (strlen(buf) <= 2 || strcmp(buf + strlen(buf) - 2, ":0") != 0) fail("exact fit distance");
+    api->get_param(inst, "lane1_steps", buf, (int)sizeof(buf));
+    if (strcmp(buf, "8") != 0) fail("lane1_steps applied");
+    api->get_param(inst, "lane1_pulses", buf, (int)sizeof(buf));
+    if (strcmp(buf, "3") != 0) fail("lane1_pulses applied");
+
+    /* The fitted pattern plays on the tapped grid positions. */
+    for (; step < 72; step++) {
+        int hit = step_once(api, inst);
+        int pos = (step - 5) % 8;
+        if (hit != (pos == 0 || pos == 3 || pos == 6)) fail("fitted pattern aligned to taps");
+    }
+
+    api->destroy_instance(inst);
+    printf("PASS: eucalypso tap-to-pattern fit\n");
+    return 0;
+}
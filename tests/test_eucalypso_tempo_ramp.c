@@ -0,0 +1,130 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+#define SAMPLE_RATE 48000
+#define MAX_STEPS 64
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_STOPPED;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+/* Reference step times by brute-force integration of the tempo curve. */
+static double integrate_seconds(double from, double to, double beats, int exp_curve, double beat) {
+    const int slices = 200000;
+    double dt = 0.0;
+    double db = beat / (double)slices;
+    int i;
+    for (i = 0; i < slices; i++) {
+        double b = ((double)i + 0.5) * db;
+        double tempo;
+        if (b >= beats) tempo = to;
+        else if (exp_curve) tempo = from * pow(to / from, b / beats);
+        else tempo = from + (to - from) * b / beats;
+        dt += db * 60.0 / tempo;
+    }
+    return dt;
+}
+
+/* Runs one-frame blocks and records the sample of every step note-on. */
+static int run_ramp(midi_fx_api_v1_t *api, const char *curve, int block, long *at) {
+    void *inst = api->create_instance("", NULL);
+    uint8_t out[64][3];
+    int lens[64];
+    uint8_t note_on[3] = { 0x90, 60, 100 };
+    uint8_t start[1] = { 0xFA };
+    long sample = 0;
+    int steps = 0;
+
+    api->set_param(inst, "lane1_steps", "1");
+    api->set_param(inst, "lane1_pulses", "1");
+    api->set_param(inst, "global_gate", "10");
+    api->process_midi(inst, note_on, 3, out, lens, 64);
+    api->process_midi(inst, start, 1, out, lens, 64);
+    (void)api->tick(inst, block, SAMPLE_RATE, out, lens, 64);
+    sample += block;
+    at[steps++] = 0;
+
+    api->set_param(inst, "ramp_curve", curve);
+    api->set_param(inst, "ramp_beats", "4");
+    api->set_param(inst, "bpm", "200");
+
+    while (steps < MAX_STEPS && sample < SAMPLE_RATE * 20) {
+        int n = api->tick(inst, block, SAMPLE_RATE, out, lens, 64);
+        int i;
+        for (i = 0; i < n; i++) {
+            if ((out[i][0] & 0xF0) == 0x90 && out[i][2] > 0 && steps < MAX_STEPS) at[steps++] = sample;
+        }
+        sample += block;
+    }
+    api->destroy_instance(inst);
+    return steps;
+}
+
+static void check_curve(midi_fx_api_v1_t *api, const char *curve, int exp_curve) {
+    long at[MAX_STEPS];
+    long coarse[MAX_STEPS];
+    int steps = run_ramp(api, curve, 1, at);
+    int coarse_steps = run_ramp(api, curve, 128, coarse);
+    int k;
+    if (steps != MAX_STEPS) fail("enough steps");
+    /* Ramp starts at step 1 (6000 samples at 120 BPM, 1/16) and spans 16 steps. */
+    for (k = 1; k < steps; k++) {
+        double ref = 6000.0 + integrate_seconds(120.0, 200.0, 4.0, exp_curve, (double)(k - 1) * 0.25) * SAMPLE_RATE;
+        if (fabs((double)at[k] - ref) > 1.0) {
+            fprintf(stderr, "%s step %d at %ld, expected %.2f\n", curve, k, at[k], ref);
+            fail("step boundary matches closed form");
+        }
+    }
+    if (at[steps - 1] - at[steps - 2] != 3600) fail("settles at target tempo");
+    /* Block size must not move the step grid. */
+    for (k = 0; k < coarse_steps && k < steps; k++) {
+        if (coarse[k] / 128 != at[k] / 128) fail("boundaries independent of block size");
+    }
+}
+
+int main(void) {
+    host_api_v1_t host;
+    midi_fx_api_v1_t *api;
+    void *inst;
+    char buf[64];
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+    api = move_midi_fx_init(&host);
+    if (api == NULL) fail("api init");
+
+    check_curve(api, "lin", 0);
+    check_curve(api, "exp", 1);
+
+    /* Recalling a state jumps straight to its tempo. */
+    inst = api->create_instance("", NULL);
+    {
+        uint8_t out[16][3];
+        int lens[16];
+        (void)api->tick(inst, 128, SAMPLE_RATE, out, lens, 16);
+    }
+    api->set_param(inst, "ramp_beats", "8");
+    api->set_param(inst, "state", "{\"bpm\":90,\"ramp_curve\":\"exp\"}");
+    api->get_param(inst, "bpm_now", buf, (int)sizeof(buf));
+    if (strcmp(buf, "90.00") != 0) fail("state load does not ramp");
+    api->get_param(inst, "ramp_curve", buf, (int)sizeof(buf));
+    if (strcmp(buf, "exp") != 0) fail("ramp_curve round trip");
+    api->destroy_instance(inst);
+
+    printf("PASS: eucalypso tempo ramps\n");
+    return 0;
+}
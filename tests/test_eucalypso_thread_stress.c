@@ -0,0 +1,228 @@
+/*
+ * Concurrency stress harness for Eucalypso.
+ *
+ * One thread plays the audio callback: it feeds MIDI into process_midi and
+ * calls tick at a 128-frame / 44.1 kHz cadence. Reader threads hammer
+ * get_param (including "state" and "error") and a writer thread hammers
+ * set_param (including full "state" loads and playhead remaps) the way the
+ * UI does.
+ *
+ * Build with -fsanitize=thread (see the .sh wrapper) so unsynchronised
+ * access between the audio and UI paths is reported. The harness also
+ * prints audio-thread callback latency under that contention.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+#define BLOCK_FRAMES 128
+#define SAMPLE_RATE 44100
+#define READER_THREADS 2
+#define MAX_BLOCKS 400000
+
+static midi_fx_api_v1_t *g_api;
+static void *g_inst;
+static int g_stop;
+static char g_state_a[8192];
+static char g_state_b[8192];
+static long g_latency_ns[MAX_BLOCKS];
+static int g_blocks;
+static long g_reads;
+static long g_writes;
+
+static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_RUNNING;
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+}
+
+static long elapsed_ns(const struct timespec *a, const struct timespec *b) {
+    return (long)(b->tv_sec - a->tv_sec) * 1000000000L + (long)(b->tv_nsec - a->tv_nsec);
+}
+
+static void timespec_add_ns(struct timespec *t, long ns) {
+    t->tv_nsec += ns;
+    while (t->tv_nsec >= 1000000000L) {
+        t->tv_nsec -= 1000000000L;
+        t->tv_sec++;
+    }
+}
+
+static void *audio_thread(void *arg) {
+    uint8_t out_msgs[128][3];
+    int out_lens[128];
+    struct timespec next;
+    long period_ns = (long)((1000000000.0 * BLOCK_FRAMES) / SAMPLE_RATE);
+    int blocks = *(int *)arg;
+    int b;
+    static const uint8_t chord[] = { 48, 55, 60, 64, 67, 71 };
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (b = 0; b < blocks; b++) {
+        struct timespec t0;
+        struct timespec t1;
+        uint8_t in[3];
+
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        timespec_add_ns(&next, period_ns);
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if (b % 8 == 0) {
+            in[0] = 0xF8;
+            (void)g_api->process_midi(g_inst, in, 1, out_msgs, out_lens, 128);
+        }
+        if (b % 64 == 0) {
+            int i;
+            int on = (b / 64) % 2 == 0;
+            for (i = 0; i < (int)sizeof(chord); i++) {
+                in[0] = on ? 0x90 : 0x80;
+                in[1] = chord[i];
+                in[2] = on ? 100 : 0;
+                (void)g_api->process_midi(g_inst, in, 3, out_msgs, out_lens, 128);
+            }
+        }
+        (void)g_api->tick(g_inst, BLOCK_FRAMES, SAMPLE_RATE, out_msgs, out_lens, 128);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        g_latency_ns[b] = elapsed_ns(&t0, &t1);
+    }
+    g_blocks = blocks;
+    __atomic_store_n(&g_stop, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void *reader_thread(void *arg) {
+    static const char *keys[] = {
+        "state", "error", "sync", "bpm", "rate", "lane1_steps", "lane2_pulses",
+        "held_order", "backlog_depth", "chain_params"
+    };
+    char buf[8192];
+    long n = 0;
+    int k = 0;
+    (void)arg;
+    while (!__atomic_load_n(&g_stop, __ATOMIC_ACQUIRE)) {
+        (void)g_api->get_param(g_inst, keys[k], buf, (int)sizeof(buf));
+        k = (k + 1) % (int)(sizeof(keys) / sizeof(keys[0]));
+        n++;
+    }
+    __atomic_fetch_add(&g_reads, n, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static char g_playhead_name[64];
+
+static void *writer_thread(void *arg) {
+    char val[16];
+    long n = 0;
+    int i = 0;
+    (void)arg;
+    while (!__atomic_load_n(&g_stop, __ATOMIC_ACQUIRE)) {
+        switch (i % 10) {
+            case 0: g_api->set_param(g_inst, "state", (i / 8) % 2 ? g_state_a : g_state_b); break;
+            case 1: g_api->set_param(g_inst, "rate", (i / 8) % 2 ? "1/16" : "1/32"); break;
+            case 2:
+                snprintf(val, sizeof(val), "%d", 60 + (i % 120));
+                g_api->set_param(g_inst, "bpm", val);
+                break;
+            case 3:
+                snprintf(val, sizeof(val), "%d", 1 + (i % 32));
+                g_api->set_param(g_inst, "lane2_steps", val);
+                break;
+            case 4: g_api->set_param(g_inst, "held_order", (i / 8) % 2 ? "rand" : "played"); break;
+            case 5: g_api->set_param(g_inst, "play_mode", (i / 8) % 2 ? "latch" : "hold"); break;
+            case 6: g_api->set_param(g_inst, "max_voices", (i / 8) % 2 ? "4" : "16"); break;
+            case 7: g_api->set_param(g_inst, "playhead_shm", (i / 10) % 2 ? g_playhead_name : "off"); break;
+            case 8: g_api->set_param(g_inst, "song", (i / 10) % 2 ? "0:1:1,1:2:1" : "1:1:2"); break;
+            default: g_api->set_param(g_inst, "lane3_enabled", (i / 8) % 2 ? "on" : "off"); break;
+        }
+        i++;
+        n++;
+    }
+    __atomic_fetch_add(&g_writes, n, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static int cmp_long(const void *a, const void *b) {
+    long x = *(const long *)a;
+    long y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv) {
+    host_api_v1_t host;
+    pthread_t audio;
+    pthread_t readers[READER_THREADS];
+    pthread_t writer;
+    double seconds = argc > 1 ? atof(argv[1]) : 5.0;
+    int blocks;
+    int i;
+    int misses = 0;
+    long period_ns = (long)((1000000000.0 * BLOCK_FRAMES) / SAMPLE_RATE);
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+
+    g_api = move_midi_fx_init(&host);
+    if (!g_api || !g_api->create_instance || !g_api->tick || !g_api->get_param || !g_api->set_param) {
+        fail("eucalypso API init/callbacks missing");
+    }
+    g_inst = g_api->create_instance(".", NULL);
+    if (!g_inst) fail("create_instance returned NULL");
+
+    g_api->set_param(g_inst, "lane2_enabled", "on");
+    g_api->set_param(g_inst, "lane2_pulses", "7");
+    g_api->set_param(g_inst, "global_gate", "400");
+    g_api->set_param(g_inst, "song_mode", "on");
+    if (g_api->get_param(g_inst, "state", g_state_a, (int)sizeof(g_state_a)) <= 0) fail("state read failed");
+    g_api->set_param(g_inst, "rate", "1/32");
+    g_api->set_param(g_inst, "held_order", "rand");
+    g_api->set_param(g_inst, "lane4_enabled", "on");
+    if (g_api->get_param(g_inst, "state", g_state_b, (int)sizeof(g_state_b)) <= 0) fail("state read failed");
+
+    blocks = (int)((seconds * SAMPLE_RATE) / BLOCK_FRAMES);
+    if (blocks < 1) blocks = 1;
+    if (blocks > MAX_BLOCKS) blocks = MAX_BLOCKS;
+
+    snprintf(g_playhead_name, sizeof(g_playhead_name), "eucalypso-stress-%d", (int)getpid());
+    pthread_create(&audio, NULL, audio_thread, &blocks);
+    for (i = 0; i < READER_THREADS; i++) pthread_create(&readers[i], NULL, reader_thread, NULL);
+    pthread_create(&writer, NULL, writer_thread, NULL);
+
+    pthread_join(audio, NULL);
+    for (i = 0; i < READER_THREADS; i++) pthread_join(readers[i], NULL);
+    pthread_join(writer, NULL);
+
+    for (i = 0; i < g_blocks; i++) {
+        if (g_latency_ns[i] > period_ns) misses++;
+    }
+    qsort(g_latency_ns, (size_t)g_blocks, sizeof(long), cmp_long);
+    printf("blocks=%d reads=%ld writes=%ld\n", g_blocks, g_reads, g_writes);
+    printf("tick latency us: p50=%.1f p99=%.1f p99.9=%.1f max=%.1f (budget %.1f, over budget %d)\n",
+           g_latency_ns[g_blocks / 2] / 1000.0,
+           g_latency_ns[(int)(g_blocks * 0.99)] / 1000.0,
+           g_latency_ns[(int)(g_blocks * 0.999)] / 1000.0,
+           g_latency_ns[g_blocks - 1] / 1000.0,
+           period_ns / 1000.0, misses);
+
+    g_api->destroy_instance(g_inst);
+    {
+        char path[96];
+        snprintf(path, sizeof(path), "/dev/shm/%s", g_playhead_name);
+        unlink(path);
+    }
+    printf("DONE: eucalypso thread stress (see ThreadSanitizer output for races)\n");
+    return 0;
+}
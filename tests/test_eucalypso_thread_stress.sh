@@ -0,0 +1,21 @@
+#!/usr/bin/env bash
+# ThreadSanitizer stress run. Usage: tests/test_eucalypso_thread_stress.sh [seconds]
+# Exits non-zero when ThreadSanitizer reports a data race.
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+MOVE_ANYTHING_SRC="${MOVE_ANYTHING_SRC:-$ROOT_DIR/../move-anything/src}"
+BIN="$ROOT_DIR/build/tests/test_eucalypso_thread_stress"
+
+mkdir -p "$(dirname "$BIN")"
+
+cc -std=c11 -Wall -Wextra -Werror -O1 -g -fsanitize=thread -pthread \
+  -DEUCALYPSO_DEBUG_LOG=0 \
+  -I"$MOVE_ANYTHING_SRC" \
+  -I"$ROOT_DIR/src" \
+  "$ROOT_DIR/tests/test_eucalypso_thread_stress.c" \
+  "$ROOT_DIR/src/dsp/eucalypso.c" \
+  -o "$BIN" \
+  -lm
+
+TSAN_OPTIONS="${TSAN_OPTIONS:-halt_on_error=0 exitcode=66}" "$BIN" "${1:-5}"
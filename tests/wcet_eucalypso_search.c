@@ -0,0 +1,421 @@
+/*
+ * Worst-case execution time search for Eucalypso.
+ *
+ * Hill-climbs with random restarts over the parameter/input space (enabled
+ * lanes, steps/pulses, gate up to 1600%, max_voices, rate, sync mode, held
+ * chord size, note order) looking for the configuration whose single
+ * slowest tick/process_midi call is the longest. Each candidate is run
+ * offline for a fixed number of blocks; its score is the minimum over a few
+ * repeats of the per-run worst call, which filters out preemption noise.
+ *
+ * The search is scored on an uninstrumented build, since instrumentation
+ * overhead would swamp the differences it is looking for. The winning
+ * configuration is printed as set_param lines so the bound can be
+ * reproduced, and saved together with the index of its worst call. A build
+ * with -finstrument-functions then replays only that call and writes it out
+ * as folded stacks (flamegraph.pl input) with raw addresses; the .sh wrapper
+ * resolves them.
+ *
+ * Usage: wcet_eucalypso_search [seed] [restarts] [config_out]
+ *        wcet_eucalypso_search --replay config_in [folded_out]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+#define NO_INSTR __attribute__((no_instrument_function))
+
+#define BLOCK_FRAMES 128
+#define SAMPLE_RATE 44100
+#define EVAL_BLOCKS 1500
+#define EVAL_REPEATS 3
+#define CLIMB_PATIENCE 24
+#define PROF_MAX_DEPTH 48
+#define PROF_MAX_STACKS 2048
+
+typedef struct {
+    int lanes_mask;
+    int steps[4];
+    int pulses[4];
+    int gate;
+    int max_voices;
+    int rate;
+    int clock_sync;
+    int chord;
+    int held_order;
+    int n_rnd;
+    int drop;
+} wcet_config_t;
+
+typedef struct {
+    int depth;
+    void *fns[PROF_MAX_DEPTH];
+    uint64_t self_ns;
+} prof_stack_t;
+
+static const char *k_rates[] = { "1/32", "1/16T", "1/16", "1/8T", "1/8", "1/4T", "1/4", "1/2", "1" };
+static const char *k_orders[] = { "up", "down", "played", "rand" };
+
+static midi_fx_api_v1_t *g_api;
+static uint32_t g_rng = 1;
+
+static int g_prof_on;
+static int g_prof_depth;
+static void *g_prof_path[PROF_MAX_DEPTH];
+static uint64_t g_prof_last;
+static prof_stack_t g_prof_stacks[PROF_MAX_STACKS];
+static int g_prof_count;
+
+NO_INSTR static int test_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_RUNNING;
+}
+
+NO_INSTR static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+NO_INSTR static uint32_t rnd(void) {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+NO_INSTR static int rnd_range(int lo, int hi) {
+    return lo + (int)(rnd() % (uint32_t)(hi - lo + 1));
+}
+
+/* ---- -finstrument-functions hooks: folded self time per call path ---- */
+
+NO_INSTR static void prof_account(void) {
+    uint64_t t = now_ns();
+    int i;
+    prof_stack_t *st = NULL;
+    if (g_prof_depth > 0) {
+        for (i = 0; i < g_prof_count; i++) {
+            if (g_prof_stacks[i].depth == g_prof_depth &&
+                memcmp(g_prof_stacks[i].fns, g_prof_path, sizeof(void *) * (size_t)g_prof_depth) == 0) {
+                st = &g_prof_stacks[i];
+                break;
+            }
+        }
+        if (!st && g_prof_count < PROF_MAX_STACKS) {
+            st = &g_prof_stacks[g_prof_count++];
+            st->depth = g_prof_depth;
+            memcpy(st->fns, g_prof_path, sizeof(void *) * (size_t)g_prof_depth);
+            st->self_ns = 0;
+        }
+        if (st) st->self_ns += t - g_prof_last;
+    }
+    g_prof_last = now_ns();
+}
+
+NO_INSTR void __cyg_profile_func_enter(void *fn, void *call_site) {
+    (void)call_site;
+    if (!g_prof_on) return;
+    prof_account();
+    if (g_prof_depth < PROF_MAX_DEPTH) g_prof_path[g_prof_depth] = fn;
+    g_prof_depth++;
+}
+
+NO_INSTR void __cyg_profile_func_exit(void *fn, void *call_site) {
+    (void)fn;
+    (void)call_site;
+    if (!g_prof_on) return;
+    prof_account();
+    if (g_prof_depth > 0) g_prof_depth--;
+}
+
+/* ---- configuration space ---- */
+
+NO_INSTR static void config_random(wcet_config_t *c) {
+    int i;
+    c->lanes_mask = rnd_range(1, 15);
+    for (i = 0; i < 4; i++) {
+        c->steps[i] = rnd_range(1, 128);
+        c->pulses[i] = rnd_range(0, c->steps[i]);
+    }
+    c->gate = rnd_range(1, 1600);
+    c->max_voices = rnd_range(1, 64);
+    c->rate = rnd_range(0, 8);
+    c->clock_sync = rnd_range(0, 1);
+    c->chord = rnd_range(1, 16);
+    c->held_order = rnd_range(0, 3);
+    c->n_rnd = rnd_range(0, 100);
+    c->drop = rnd_range(0, 100);
+}
+
+NO_INSTR static int clampi(int v, int lo, int hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+NO_INSTR static void config_mutate(wcet_config_t *c) {
+    int lane = rnd_range(0, 3);
+    int big = rnd_range(0, 3) == 0;
+    switch (rnd_range(0, 10)) {
+        case 0: c->lanes_mask = clampi(c->lanes_mask ^ (1 << lane), 1, 15); break;
+        case 1: c->steps[lane] = clampi(c->steps[lane] + (big ? rnd_range(-32, 32) : rnd_range(-2, 2)), 1, 128); break;
+        case 2: c->pulses[lane] = clampi(c->pulses[lane] + (big ? rnd_range(-32, 32) : rnd_range(-2, 2)), 0, 128); break;
+        case 3: c->gate = clampi(c->gate + (big ? rnd_range(-400, 400) : rnd_range(-50, 50)), 1, 1600); break;
+        case 4: c->max_voices = clampi(c->max_voices + (big ? rnd_range(-16, 16) : rnd_range(-2, 2)), 1, 64); break;
+        case 5: c->rate = clampi(c->rate + rnd_range(-1, 1), 0, 8); break;
+        case 6: c->clock_sync ^= 1; break;
+        case 7: c->chord = clampi(c->chord + rnd_range(-2, 2), 1, 16); break;
+        case 8: c->held_order = rnd_range(0, 3); break;
+        case 9: c->n_rnd = clampi(c->n_rnd + rnd_range(-20, 20), 0, 100); break;
+        default: c->drop = clampi(c->drop + rnd_range(-20, 20), 0, 100); break;
+    }
+    c->pulses[lane] = clampi(c->pulses[lane], 0, c->steps[lane]);
+}
+
+NO_INSTR static void config_print(FILE *f, const wcet_config_t *c) {
+    int i;
+    fprintf(f, "sync=%s\nrate=%s\nmax_voices=%d\nglobal_gate=%d\nheld_order=%s\n",
+            c->clock_sync ? "clock" : "internal", k_rates[c->rate], c->max_voices, c->gate,
+            k_orders[c->held_order]);
+    for (i = 0; i < 4; i++) {
+        fprintf(f, "lane%d_enabled=%s\nlane%d_steps=%d\nlane%d_pulses=%d\nlane%d_n_rnd=%d\nlane%d_drop=%d\n",
+                i + 1, (c->lanes_mask >> i) & 1 ? "on" : "off",
+                i + 1, c->steps[i], i + 1, c->pulses[i], i + 1, c->n_rnd, i + 1, c->drop);
+    }
+    fprintf(f, "# held chord size: %d\n", c->chord);
+}
+
+NO_INSTR static int config_save(const char *path, const wcet_config_t *c, long worst_call) {
+    FILE *f = fopen(path, "w");
+    int i;
+    if (!f) {
+        perror(path);
+        return 0;
+    }
+    fprintf(f, "%d %d %d %d %d %d %d %d %d", c->lanes_mask, c->gate, c->max_voices, c->rate, c->clock_sync,
+            c->chord, c->held_order, c->n_rnd, c->drop);
+    for (i = 0; i < 4; i++) fprintf(f, " %d %d", c->steps[i], c->pulses[i]);
+    fprintf(f, " %ld\n", worst_call);
+    return fclose(f) == 0;
+}
+
+NO_INSTR static int config_load(const char *path, wcet_config_t *c, long *worst_call) {
+    FILE *f = fopen(path, "r");
+    int n;
+    int i;
+    if (!f) {
+        perror(path);
+        return 0;
+    }
+    n = fscanf(f, "%d %d %d %d %d %d %d %d %d", &c->lanes_mask, &c->gate, &c->max_voices, &c->rate,
+               &c->clock_sync, &c->chord, &c->held_order, &c->n_rnd, &c->drop);
+    for (i = 0; i < 4; i++) n += fscanf(f, "%d %d", &c->steps[i], &c->pulses[i]);
+    n += fscanf(f, "%ld", worst_call);
+    fclose(f);
+    return n == 18;
+}
+
+NO_INSTR static void *config_instance(const wcet_config_t *c) {
+    void *inst = g_api->create_instance(".", NULL);
+    char key[32];
+    char val[16];
+    int i;
+    if (!inst) return NULL;
+    g_api->set_param(inst, "sync", c->clock_sync ? "clock" : "internal");
+    g_api->set_param(inst, "rate", k_rates[c->rate]);
+    g_api->set_param(inst, "bpm", "240");
+    snprintf(val, sizeof(val), "%d", c->max_voices);
+    g_api->set_param(inst, "max_voices", val);
+    snprintf(val, sizeof(val), "%d", c->gate);
+    g_api->set_param(inst, "global_gate", val);
+    g_api->set_param(inst, "held_order", k_orders[c->held_order]);
+    for (i = 0; i < 4; i++) {
+        snprintf(key, sizeof(key), "lane%d_enabled", i + 1);
+        g_api->set_param(inst, key, (c->lanes_mask >> i) & 1 ? "on" : "off");
+        snprintf(key, sizeof(key), "lane%d_steps", i + 1);
+        snprintf(val, sizeof(val), "%d", c->steps[i]);
+        g_api->set_param(inst, key, val);
+        snprintf(key, sizeof(key), "lane%d_pulses", i + 1);
+        snprintf(val, sizeof(val), "%d", c->pulses[i]);
+        g_api->set_param(inst, key, val);
+        snprintf(key, sizeof(key), "lane%d_note", i + 1);
+        snprintf(val, sizeof(val), "%d", 1 + (i * 5) % 24);
+        g_api->set_param(inst, key, val);
+        snprintf(key, sizeof(key), "lane%d_n_rnd", i + 1);
+        snprintf(val, sizeof(val), "%d", c->n_rnd);
+        g_api->set_param(inst, key, val);
+        snprintf(key, sizeof(key), "lane%d_drop", i + 1);
+        snprintf(val, sizeof(val), "%d", c->drop);
+        g_api->set_param(inst, key, val);
+    }
+    return inst;
+}
+
+/*
+ * Runs one candidate. Returns the slowest single call in ns and stores its
+ * call index. When profile_call >= 0, the profiler is enabled for that call.
+ */
+NO_INSTR static uint64_t run_config(const wcet_config_t *c, long profile_call, long *worst_call) {
+    uint8_t out_msgs[256][3];
+    int out_lens[256];
+    uint8_t msg[3];
+    void *inst = config_instance(c);
+    double clock_interval = (SAMPLE_RATE * 60.0) / (240.0 * 24.0);
+    double next_clock = 0.0;
+    double now = 0.0;
+    uint64_t worst = 0;
+    long call = 0;
+    int b;
+    int i;
+
+    if (!inst) return 0;
+
+#define TIMED_CALL(expr) \
+    do { \
+        uint64_t t0_; \
+        uint64_t dt_; \
+        if (call == profile_call) { g_prof_depth = 0; g_prof_last = now_ns(); g_prof_on = 1; } \
+        t0_ = now_ns(); \
+        (void)(expr); \
+        dt_ = now_ns() - t0_; \
+        g_prof_on = 0; \
+        if (dt_ > worst) { worst = dt_; if (worst_call) *worst_call = call; } \
+        call++; \
+    } while (0)
+
+    (void)g_api->tick(inst, BLOCK_FRAMES, SAMPLE_RATE, out_msgs, out_lens, 256);
+    for (i = 0; i < c->chord; i++) {
+        msg[0] = 0x90;
+        msg[1] = (uint8_t)(36 + i * 3);
+        msg[2] = 100;
+        TIMED_CALL(g_api->process_midi(inst, msg, 3, out_msgs, out_lens, 256));
+    }
+    msg[0] = 0xFA;
+    TIMED_CALL(g_api->process_midi(inst, msg, 1, out_msgs, out_lens, 256));
+    for (b = 0; b < EVAL_BLOCKS; b++) {
+        while (c->clock_sync && next_clock <= now) {
+            msg[0] = 0xF8;
+            TIMED_CALL(g_api->process_midi(inst, msg, 1, out_msgs, out_lens, 256));
+            next_clock += clock_interval;
+        }
+        TIMED_CALL(g_api->tick(inst, BLOCK_FRAMES, SAMPLE_RATE, out_msgs, out_lens, 256));
+        now += BLOCK_FRAMES;
+    }
+#undef TIMED_CALL
+
+    g_api->destroy_instance(inst);
+    return worst;
+}
+
+NO_INSTR static uint64_t score_config(const wcet_config_t *c) {
+    uint64_t best = UINT64_MAX;
+    int r;
+    for (r = 0; r < EVAL_REPEATS; r++) {
+        uint64_t w = run_config(c, -1, NULL);
+        if (w < best) best = w;
+    }
+    return best;
+}
+
+NO_INSTR static void write_folded(const char *path) {
+    FILE *f = fopen(path, "w");
+    int i;
+    int d;
+    if (!f) {
+        perror(path);
+        return;
+    }
+    for (i = 0; i < g_prof_count; i++) {
+        for (d = 0; d < g_prof_stacks[i].depth && d < PROF_MAX_DEPTH; d++) {
+            fprintf(f, "%s%p", d ? ";" : "", g_prof_stacks[i].fns[d]);
+        }
+        fprintf(f, " %llu\n", (unsigned long long)g_prof_stacks[i].self_ns);
+    }
+    fclose(f);
+}
+
+/* Replays the saved worst call with the profiler enabled. */
+NO_INSTR static int replay_worst(const char *config_path, const char *folded_path) {
+    wcet_config_t c;
+    long worst_call = -1;
+    uint64_t replay;
+    memset(&c, 0, sizeof(c));
+    if (!config_load(config_path, &c, &worst_call)) {
+        fprintf(stderr, "cannot read configuration from %s\n", config_path);
+        return 1;
+    }
+    replay = run_config(&c, worst_call, NULL);
+    write_folded(folded_path);
+    printf("profiled call %ld (%.2f us worst instrumented call), folded stacks: %s\n",
+           worst_call, replay / 1000.0, folded_path);
+    return 0;
+}
+
+int main(int argc, char **argv) NO_INSTR;
+int main(int argc, char **argv) {
+    host_api_v1_t host;
+    wcet_config_t best;
+    uint64_t best_score = 0;
+    unsigned seed;
+    int restarts;
+    const char *config_path;
+    long worst_call = -1;
+    int r;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = test_get_clock_status;
+    g_api = move_midi_fx_init(&host);
+    if (!g_api) return 1;
+
+    if (argc > 2 && strcmp(argv[1], "--replay") == 0) {
+        return replay_worst(argv[2], argc > 3 ? argv[3] : "wcet_folded.txt");
+    }
+    seed = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : 1u;
+    restarts = argc > 2 ? atoi(argv[2]) : 8;
+    config_path = argc > 3 ? argv[3] : "wcet_config.txt";
+
+    g_rng = seed ? seed : 1u;
+    memset(&best, 0, sizeof(best));
+    for (r = 0; r < restarts; r++) {
+        wcet_config_t cur;
+        uint64_t cur_score;
+        int stale = 0;
+        config_random(&cur);
+        cur_score = score_config(&cur);
+        while (stale < CLIMB_PATIENCE) {
+            wcet_config_t cand = cur;
+            uint64_t s;
+            config_mutate(&cand);
+            s = score_config(&cand);
+            if (s > cur_score) {
+                cur = cand;
+                cur_score = s;
+                stale = 0;
+            } else {
+                stale++;
+            }
+        }
+        printf("restart %d: worst call %.2f us\n", r, cur_score / 1000.0);
+        if (cur_score > best_score) {
+            best = cur;
+            best_score = cur_score;
+        }
+    }
+
+    printf("\nWCET candidate: %.2f us (block budget %.2f us, seed %u, %d restarts)\n",
+           best_score / 1000.0, (1000000.0 * BLOCK_FRAMES) / SAMPLE_RATE, seed, restarts);
+    config_print(stdout, &best);
+
+    (void)run_config(&best, -1, &worst_call);
+    if (!config_save(config_path, &best, worst_call)) return 1;
+    printf("worst call %ld, configuration: %s\n", worst_call, config_path);
+    return 0;
+}
@@ -0,0 +1,61 @@
+#!/usr/bin/env bash
+# Worst-case execution time search.
+# Usage: tests/wcet_eucalypso_search.sh [seed] [restarts]
+# Searches with a plain -O2 build and prints the slowest configuration found.
+# Its worst call is then replayed once with an -finstrument-functions build,
+# and a resolved folded-stack profile of that call is written to
+# build/wcet/wcet_folded.txt (flamegraph.pl input).
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+MOVE_ANYTHING_SRC="${MOVE_ANYTHING_SRC:-$ROOT_DIR/../move-anything/src}"
+OUT_DIR="$ROOT_DIR/build/wcet"
+BIN="$OUT_DIR/wcet_eucalypso_search"
+BIN_INSTR="$OUT_DIR/wcet_eucalypso_replay"
+CONFIG="$OUT_DIR/wcet_config.txt"
+RAW="$OUT_DIR/wcet_folded_raw.txt"
+FOLDED="$OUT_DIR/wcet_folded.txt"
+
+mkdir -p "$OUT_DIR"
+
+for variant in plain instr; do
+  extra=""
+  [ "$variant" = instr ] && extra="-finstrument-functions"
+  cc -std=c11 -Wall -Wextra -Werror -O2 -g -no-pie -fno-pie \
+    -DEUCALYPSO_DEBUG_LOG=0 \
+    -I"$MOVE_ANYTHING_SRC" \
+    -I"$ROOT_DIR/src" \
+    -c "$ROOT_DIR/src/dsp/eucalypso.c" \
+    $extra \
+    -o "$OUT_DIR/eucalypso_$variant.o"
+done
+
+for variant in plain instr; do
+  out="$BIN"
+  [ "$variant" = instr ] && out="$BIN_INSTR"
+  cc -std=c11 -Wall -Wextra -Werror -O2 -g -no-pie -fno-pie \
+    -I"$MOVE_ANYTHING_SRC" \
+    -I"$ROOT_DIR/src" \
+    "$ROOT_DIR/tests/wcet_eucalypso_search.c" \
+    "$OUT_DIR/eucalypso_$variant.o" \
+    -o "$out" \
+    -lm
+done
+
+"$BIN" "${1:-1}" "${2:-8}" "$CONFIG"
+"$BIN_INSTR" --replay "$CONFIG" "$RAW"
+
+# Resolve raw addresses to function names.
+addrs="$(tr ' ;' '\n\n' < "$RAW" | grep '^0x' | sort -u || true)"
+cp "$RAW" "$FOLDED"
+if [ -n "$addrs" ]; then
+  paste -d' ' <(echo "$addrs") <(echo "$addrs" | addr2line -f -e "$BIN_INSTR" | sed -n '1~2p') |
+    while read -r addr name; do
+      sed -i "s/\b$addr\b/$name/g" "$FOLDED"
+    done
+fi
+
+echo ""
+echo "Self time by function (ns):"
+awk '{ n = split($1, f, ";"); t[f[n]] += $2 } END { for (k in t) printf "%12d  %s\n", t[k], k }' "$FOLDED" |
+  sort -rn | head -15
@@ -0,0 +1,246 @@
+/*
+ * eucalypso_pack_presets: build a memory-mappable preset library.
+ *
+ * Each input is a state JSON file as produced by get_param("state"). The
+ * preset name is the file's base name without extension; an optional
+ * top-level "tags" string is stored alongside it. Every file is loaded into
+ * a scratch instance and its parameters are read back as a fixed-size
+ * block via get_param("preset_block"), so the field layout is defined by
+ * the module alone.
+ *
+ * Usage:
+ *     eucalypso_pack_presets -o presets.eupl presets/one.json presets/two.json
+ *
+ * The module maps <module_dir>/presets.eupl on first use (see README).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+#define LIB_MAGIC 0x4c505545u
+/* Must match PRESET_LIB_VERSION in src/dsp/eucalypso.c. */
+#define LIB_VERSION 2
+#define HEADER_SIZE 24
+#define ENTRY_SIZE 64
+#define NAME_LEN 32
+#define TAGS_LEN 24
+#define BLOCK_HEX_MAX 4096
+
+typedef struct {
+    char name[NAME_LEN];
+    char tags[TAGS_LEN];
+    uint8_t *block;
+    int block_len;
+    uint32_t block_index;
+} pack_entry_t;
+
+static int pack_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_STOPPED;
+}
+
+static char *read_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    char *buf;
+    long size;
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size < 0) {
+        fclose(f);
+        return NULL;
+    }
+    buf = (char *)malloc((size_t)size + 1);
+    if (buf && fread(buf, 1, (size_t)size, f) != (size_t)size) {
+        free(buf);
+        buf = NULL;
+    }
+    if (buf) buf[size] = '\0';
+    fclose(f);
+    return buf;
+}
+
+static void base_name(const char *path, char *out, size_t out_len) {
+    const char *start = strrchr(path, '/');
+    const char *dot;
+    size_t len;
+    start = start ? start + 1 : path;
+    dot = strrchr(start, '.');
+    len = dot && dot != start ? (size_t)(dot - start) : strlen(start);
+    if (len >= out_len) len = out_len - 1;
+    memcpy(out, start, len);
+    out[len] = '\0';
+}
+
+static void json_tags(const char *json, char *out, size_t out_len) {
+    const char *p = strstr(json, "\"tags\"");
+    size_t n = 0;
+    out[0] = '\0';
+    if (!p) return;
+    p = strchr(p + 6, ':');
+    if (!p) return;
+    p++;
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+    if (*p != '"') return;
+    p++;
+    while (*p && *p != '"' && n + 1 < out_len) out[n++] = *p++;
+    out[n] = '\0';
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static int compare_entries(const void *a, const void *b) {
+    return strncmp(((const pack_entry_t *)a)->name, ((const pack_entry_t *)b)->name, NAME_LEN);
+}
+
+static void put_le16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static int load_entry(midi_fx_api_v1_t *api, const char *path, pack_entry_t *entry) {
+    char hex[BLOCK_HEX_MAX];
+    char *json = read_file(path);
+    void *inst;
+    int len;
+    int i;
+    if (!json) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return 0;
+    }
+    inst = api->create_instance("", NULL);
+    if (!inst) {
+        free(json);
+        return 0;
+    }
+    api->set_param(inst, "state", json);
+    len = api->get_param(inst, "preset_block", hex, (int)sizeof(hex));
+    api->destroy_instance(inst);
+
+    base_name(path, entry->name, sizeof(entry->name));
+    json_tags(json, entry->tags, sizeof(entry->tags));
+    free(json);
+    if (len <= 0 || (len % 8) != 0) {
+        fprintf(stderr, "module returned no preset block for %s\n", path);
+        return 0;
+    }
+    entry->block_len = len / 2;
+    entry->block = (uint8_t *)malloc((size_t)entry->block_len);
+    if (!entry->block) return 0;
+    for (i = 0; i < entry->block_len; i++) {
+        entry->block[i] = (uint8_t)((hex_value(hex[i * 2]) << 4) | hex_value(hex[i * 2 + 1]));
+    }
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    const char *out_path = NULL;
+    host_api_v1_t host;
+    midi_fx_api_v1_t *api;
+    pack_entry_t *entries;
+    uint8_t header[HEADER_SIZE];
+    FILE *out;
+    int count;
+    int opt;
+    int i;
+    uint32_t index_offset = HEADER_SIZE;
+    uint32_t blocks_offset;
+
+    while ((opt = getopt(argc, argv, "o:")) != -1) {
+        if (opt == 'o') out_path = optarg;
+        else {
+            fprintf(stderr, "usage: %s -o OUT.eupl STATE.json...\n", argv[0]);
+            return 2;
+        }
+    }
+    count = argc - optind;
+    if (!out_path || count <= 0) {
+        fprintf(stderr, "usage: %s -o OUT.eupl STATE.json...\n", argv[0]);
+        return 2;
+    }
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = pack_get_clock_status;
+    api = move_midi_fx_init(&host);
+    if (!api || !api->create_instance) return 1;
+
+    entries = (pack_entry_t *)calloc((size_t)count, sizeof(*entries));
+    if (!entries) return 1;
+    for (i = 0; i < count; i++) {
+        if (!load_entry(api, argv[optind + i], &entries[i])) return 1;
+        entries[i].block_index = (uint32_t)i;
+        if (entries[i].block_len != entries[0].block_len) {
+            fprintf(stderr, "block size mismatch in %s\n", argv[optind + i]);
+            return 1;
+        }
+    }
+    qsort(entries, (size_t)count, sizeof(*entries), compare_entries);
+    for (i = 1; i < count; i++) {
+        if (strncmp(entries[i - 1].name, entries[i].name, NAME_LEN) == 0) {
+            fprintf(stderr, "duplicate preset name: %s\n", entries[i].name);
+            return 1;
+        }
+    }
+
+    blocks_offset = index_offset + (uint32_t)count * ENTRY_SIZE;
+    memset(header, 0, sizeof(header));
+    put_le32(header, LIB_MAGIC);
+    put_le16(header + 4, LIB_VERSION);
+    put_le16(header + 6, (uint16_t)(entries[0].block_len / 4));
+    put_le32(header + 8, (uint32_t)count);
+    put_le32(header + 12, index_offset);
+    put_le32(header + 16, blocks_offset);
+
+    out = fopen(out_path, "wb");
+    if (!out) {
+        fprintf(stderr, "cannot write %s\n", out_path);
+        return 1;
+    }
+    fwrite(header, 1, sizeof(header), out);
+    for (i = 0; i < count; i++) {
+        uint8_t entry[ENTRY_SIZE];
+        memset(entry, 0, sizeof(entry));
+        memcpy(entry, entries[i].name, NAME_LEN);
+        memcpy(entry + NAME_LEN, entries[i].tags, TAGS_LEN);
+        put_le32(entry + NAME_LEN + TAGS_LEN, entries[i].block_index);
+        fwrite(entry, 1, sizeof(entry), out);
+    }
+    /* Blocks stay in input order; the sorted index points back into them. */
+    for (i = 0; i < count; i++) {
+        int j;
+        for (j = 0; j < count; j++) {
+            if (entries[j].block_index == (uint32_t)i) {
+                fwrite(entries[j].block, 1, (size_t)entries[j].block_len, out);
+                break;
+            }
+        }
+    }
+    if (fclose(out) != 0) return 1;
+
+    printf("%s: %d presets, %d fields each\n", out_path, count, entries[0].block_len / 4);
+    for (i = 0; i < count; i++) free(entries[i].block);
+    free(entries);
+    return 0;
+}
@@ -0,0 +1,256 @@
+/*
+ * eucalypso_stream: desktop host for the Eucalypso MIDI FX.
+ *
+ * Reads timestamped raw MIDI, runs it through the module with a simulated
+ * sample clock, and streams the sequenced output to stdout. Useful for
+ * rehearsal and long soak runs without a Move.
+ *
+ * Input lines (stdin or -i FILE), time-ordered:
+ *     <sample_time> <hex byte> [<hex byte> ...]     e.g. "0 90 3c 64"
+ * Blank lines and lines starting with '#' are ignored.
+ *
+ * Output lines:
+ *     <sample_time> <hex byte> [<hex byte> ...]
+ * Messages from tick() are stamped with the start of the block that
+ * produced them; pass-through messages carry their input time.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "host/midi_fx_api_v1.h"
+#include "host/plugin_api_v1.h"
+
+extern midi_fx_api_v1_t *move_midi_fx_init(const host_api_v1_t *host);
+
+#define MAX_OUT 256
+#define LINE_MAX_LEN 512
+
+typedef struct {
+    uint64_t time;
+    uint8_t msg[3];
+    int len;
+    int valid;
+} stream_event_t;
+
+static int stream_get_clock_status(void) {
+    return MOVE_CLOCK_STATUS_RUNNING;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -i FILE      read events from FILE instead of stdin\n"
+            "  -b FRAMES    block size in frames (default 128)\n"
+            "  -r RATE      sample rate in Hz (default 44100)\n"
+            "  -x SPEED     pacing: 1 = real time (default), 4 = 4x, 0 = as fast as possible\n"
+            "  -d SECONDS   total run length (default: input end plus tail)\n"
+            "  -t SECONDS   tail to run after the last input event (default 2)\n"
+            "  -c BPM       generate MIDI Start + 24 PPQN clock at BPM\n"
+            "  -s KEY=VAL   set_param before running (repeatable)\n"
+            "  -S FILE      load a state JSON file before running\n",
+            argv0);
+}
+
+static int read_event(FILE *in, stream_event_t *ev) {
+    char line[LINE_MAX_LEN];
+    while (fgets(line, sizeof(line), in)) {
+        char *p = line;
+        char *end;
+        unsigned long long t;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') continue;
+        t = strtoull(p, &end, 10);
+        if (end == p) {
+            fprintf(stderr, "skipping malformed line: %s", line);
+            continue;
+        }
+        ev->time = (uint64_t)t;
+        ev->len = 0;
+        p = end;
+        while (ev->len < 3) {
+            unsigned long b = strtoul(p, &end, 16);
+            if (end == p) break;
+            ev->msg[ev->len++] = (uint8_t)(b & 0xFF);
+            p = end;
+        }
+        if (ev->len < 1) continue;
+        ev->valid = 1;
+        return 1;
+    }
+    ev->valid = 0;
+    return 0;
+}
+
+static void write_msgs(FILE *out, uint64_t time, uint8_t msgs[][3], const int lens[], int count) {
+    int i;
+    int j;
+    for (i = 0; i < count; i++) {
+        fprintf(out, "%llu", (unsigned long long)time);
+        for (j = 0; j < lens[i] && j < 3; j++) fprintf(out, " %02x", msgs[i][j]);
+        fputc('\n', out);
+    }
+}
+
+static char *read_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    char *buf;
+    long size;
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size < 0) {
+        fclose(f);
+        return NULL;
+    }
+    buf = (char *)malloc((size_t)size + 1);
+    if (buf && fread(buf, 1, (size_t)size, f) != (size_t)size) {
+        free(buf);
+        buf = NULL;
+    }
+    if (buf) buf[size] = '\0';
+    fclose(f);
+    return buf;
+}
+
+static void pace(const struct timespec *start, uint64_t samples, int sample_rate, double speed) {
+    struct timespec target = *start;
+    double secs;
+    if (speed <= 0.0) return;
+    secs = ((double)samples / (double)sample_rate) / speed;
+    target.tv_sec += (time_t)secs;
+    target.tv_nsec += (long)((secs - (double)(time_t)secs) * 1e9);
+    if (target.tv_nsec >= 1000000000L) {
+        target.tv_nsec -= 1000000000L;
+        target.tv_sec++;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &target, NULL);
+}
+
+int main(int argc, char **argv) {
+    host_api_v1_t host;
+    midi_fx_api_v1_t *api;
+    void *inst;
+    FILE *in = stdin;
+    stream_event_t ev;
+    uint8_t out_msgs[MAX_OUT][3];
+    int out_lens[MAX_OUT];
+    struct timespec start;
+    int frames = 128;
+    int sample_rate = 44100;
+    double speed = 1.0;
+    double duration = -1.0;
+    double tail = 2.0;
+    double clock_bpm = 0.0;
+    double clock_interval = 0.0;
+    double next_clock = 0.0;
+    uint64_t now = 0;
+    uint64_t end_time = 0;
+    int opt;
+    int n;
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.get_clock_status = stream_get_clock_status;
+    api = move_midi_fx_init(&host);
+    if (!api || !api->create_instance) return 1;
+    inst = api->create_instance(".", NULL);
+    if (!inst) return 1;
+
+    while ((opt = getopt(argc, argv, "i:b:r:x:d:t:c:s:S:h")) != -1) {
+        switch (opt) {
+            case 'i':
+                in = fopen(optarg, "r");
+                if (!in) {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            case 'b': frames = atoi(optarg); break;
+            case 'r': sample_rate = atoi(optarg); break;
+            case 'x': speed = atof(optarg); break;
+            case 'd': duration = atof(optarg); break;
+            case 't': tail = atof(optarg); break;
+            case 'c': clock_bpm = atof(optarg); break;
+            case 's': {
+                char *eq = strchr(optarg, '=');
+                if (!eq) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                *eq = '\0';
+                api->set_param(inst, optarg, eq + 1);
+                break;
+            }
+            case 'S': {
+                char *json = read_file(optarg);
+                if (!json) {
+                    perror(optarg);
+                    return 1;
+                }
+                api->set_param(inst, "state", json);
+                free(json);
+                break;
+            }
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (frames < 1 || sample_rate < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (duration >= 0.0) end_time = (uint64_t)(duration * sample_rate);
+
+    if (clock_bpm > 0.0) {
+        uint8_t start_msg[1] = { 0xFA };
+        clock_interval = ((double)sample_rate * 60.0) / (clock_bpm * 24.0);
+        n = api->process_midi(inst, start_msg, 1, out_msgs, out_lens, MAX_OUT);
+        write_msgs(stdout, 0, out_msgs, out_lens, n);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    (void)read_event(in, &ev);
+    for (;;) {
+        uint64_t block_end = now + (uint64_t)frames;
+        if (duration >= 0.0) {
+            if (now >= end_time) break;
+        } else if (!ev.valid) {
+            if (end_time == 0) end_time = now + (uint64_t)(tail * sample_rate);
+            if (now >= end_time) break;
+        }
+
+        while (ev.valid && ev.time < block_end) {
+            n = api->process_midi(inst, ev.msg, ev.len, out_msgs, out_lens, MAX_OUT);
+            write_msgs(stdout, ev.time, out_msgs, out_lens, n);
+            (void)read_event(in, &ev);
+        }
+        while (clock_interval > 0.0 && next_clock < (double)block_end) {
+            uint8_t clk[1] = { 0xF8 };
+            n = api->process_midi(inst, clk, 1, out_msgs, out_lens, MAX_OUT);
+            write_msgs(stdout, (uint64_t)next_clock, out_msgs, out_lens, n);
+            next_clock += clock_interval;
+        }
+
+        n = api->tick(inst, frames, sample_rate, out_msgs, out_lens, MAX_OUT);
+        write_msgs(stdout, now, out_msgs, out_lens, n);
+        now = block_end;
+
+        if (speed > 0.0) {
+            fflush(stdout);
+            pace(&start, now, sample_rate, speed);
+        }
+    }
+
+    fflush(stdout);
+    api->destroy_instance(inst);
+    if (in != stdin) fclose(in);
+    return 0;
+}